@@ -18,10 +18,34 @@ static uint16_t p_ms = 0;
 #define DEBUG_DATA0_ADDRESS  ((volatile uint32_t*)0xE00000F4)
 #define DEBUG_DATA1_ADDRESS  ((volatile uint32_t*)0xE00000F8)
 
+#if (SDI_PRINT == SDI_PR_CLOSE) && (PRINTF_BUF != PRINTF_BUF_OFF)
+#if (PRINTF_BUF_SIZE & (PRINTF_BUF_SIZE - 1)) || (PRINTF_BUF_SIZE > 0x8000)
+#error PRINTF_BUF_SIZE must be a power of 2
+#endif
+
+#define PRINTF_BUF_DMA   1
+
+void DMA1_Channel4_IRQHandler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
+
+/* Single producer ring: Head is moved only by _write, Tail only by the DMA interrupt */
+static uint8_t Tx_Buf[PRINTF_BUF_SIZE];
+static volatile uint16_t Tx_Head;
+static volatile uint16_t Tx_Tail;
+static volatile uint16_t Tx_Len;   //Bytes in the running transfer (0:DMA idle)
+#define TX_FULL(head)   ((((head) - Tx_Tail) & (PRINTF_BUF_SIZE - 1)) == PRINTF_BUF_SIZE - 1)
+#if (PRINTF_BUF == PRINTF_BUF_COUNT)
+static volatile uint32_t Tx_Dropped;
+#endif
+#else
+#define PRINTF_BUF_DMA   0
+#endif
+
 /*********************************************************************
  * @fn      Delay_Init
  *
- * @brief   Initializes Delay Funcation.
+ * @brief   Initializes Delay Funcation. SysTick is left free running
+ *        at HCLK/8 and its compare match raises the 1ms tick
+ *        interrupt, SysTick_Handler must call Delay_Tick.
  *
  * @return  none
  */
@@ -29,6 +53,46 @@ void Delay_Init(void)
 {
     p_us = SystemCoreClock / 8000000;
     p_ms = (uint16_t)p_us * 1000;
+
+    SysTick->CTLR = 0;
+    SysTick->SR = 0;
+    SysTick->CNT = 0;
+    SysTick->CMP = p_ms;
+    SysTick->CTLR = (1 << 1) | (1 << 0);   //STIE, STE (HCLK/8, no reload)
+    NVIC_EnableIRQ(SysTicK_IRQn);
+}
+
+/*********************************************************************
+ * @fn      Delay_Update
+ *
+ * @brief   Recomputes the SysTick counts per us and ms after a change
+ *        of SystemCoreClock and restarts the 1ms tick from now.
+ *
+ * @return  none
+ */
+void Delay_Update(void)
+{
+    p_us = SystemCoreClock / 8000000;
+    p_ms = (uint16_t)p_us * 1000;
+
+    SysTick->CMP = SysTick->CNT + p_ms;
+}
+
+/*********************************************************************
+ * @fn      Delay_Tick
+ *
+ * @brief   Acknowledges the 1ms tick and sets the next compare match.
+ *
+ * @return  none
+ */
+void Delay_Tick(void)
+{
+    uint32_t cmp = SysTick->CMP + p_ms;
+
+    if((int32_t)(cmp - SysTick->CNT) <= 0)  //Tick was held off for over 1ms
+        cmp = SysTick->CNT + p_ms;
+    SysTick->CMP = cmp;
+    SysTick->SR = 0;
 }
 
 /*********************************************************************
@@ -44,15 +108,9 @@ void Delay_Us(uint32_t n)
 {
     uint32_t i;
 
-    SysTick->SR &= ~(1 << 0);
-    i = (uint32_t)n * p_us;
+    i = SysTick->CNT + (uint32_t)n * p_us;
 
-    SysTick->CMP = i;
-    SysTick->CNT = 0;
-    SysTick->CTLR |=(1 << 0);
-
-    while((SysTick->SR & (1 << 0)) != (1 << 0));
-    SysTick->CTLR &= ~(1 << 0);
+    while((int32_t)(SysTick->CNT - i) < 0);
 }
 
 /*********************************************************************
@@ -68,15 +126,13 @@ void Delay_Ms(uint32_t n)
 {
     uint32_t i;
 
-    SysTick->SR &= ~(1 << 0);
-    i = (uint32_t)n * p_ms;
-
-    SysTick->CMP = i;
-    SysTick->CNT = 0;
-    SysTick->CTLR |=(1 << 0);
+    i = SysTick->CNT;
 
-    while((SysTick->SR & (1 << 0)) != (1 << 0));
-    SysTick->CTLR &= ~(1 << 0);
+    while(n--)
+    {
+        i += p_ms;
+        while((int32_t)(SysTick->CNT - i) < 0);
+    }
 }
 
 /*********************************************************************
@@ -92,6 +148,10 @@ void USART_Printf_Init(uint32_t baudrate)
 {
     GPIO_InitTypeDef  GPIO_InitStructure;
     USART_InitTypeDef USART_InitStructure;
+#if PRINTF_BUF_DMA
+    DMA_InitTypeDef  DMA_InitStructure = {0};
+    NVIC_InitTypeDef NVIC_InitStructure = {0};
+#endif
 
 #if (DEBUG == DEBUG_UART1_NoRemap)
     RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOD | RCC_APB2Periph_USART1, ENABLE);
@@ -139,6 +199,34 @@ void USART_Printf_Init(uint32_t baudrate)
 
     USART_Init(USART1, &USART_InitStructure);
     USART_Cmd(USART1, ENABLE);
+
+#if PRINTF_BUF_DMA
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+    DMA_DeInit(DMA1_Channel4);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&USART1->DATAR;
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)Tx_Buf;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+    DMA_InitStructure.DMA_BufferSize = 0;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_Low;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init(DMA1_Channel4, &DMA_InitStructure);
+    DMA_ITConfig(DMA1_Channel4, DMA_IT_TC, ENABLE);
+
+    NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel4_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 3;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
+
+    Tx_Head = Tx_Tail = Tx_Len = 0;
+    USART_DMACmd(USART1, USART_DMAReq_Tx, ENABLE);
+#endif
 }
 
 /*********************************************************************
@@ -157,6 +245,78 @@ void SDI_Printf_Enable(void)
     Delay_Ms(1);
 }
 
+#if PRINTF_BUF_DMA
+/*********************************************************************
+ * @fn      Tx_Start
+ *
+ * @brief   Start DMA on the contiguous data at Tx_Tail. Called with the
+ *        DMA idle, from _write or from the DMA interrupt.
+ *
+ * @return  None
+ */
+static void Tx_Start(void)
+{
+    uint16_t head = Tx_Head, tail = Tx_Tail;
+    uint16_t len = (head >= tail) ? head - tail : PRINTF_BUF_SIZE - tail;
+
+    Tx_Len = len;
+    if(len)
+    {
+        DMA1_Channel4->CFGR &= ~DMA_CFGR1_EN;
+        DMA1_Channel4->MADDR = (uint32_t)&Tx_Buf[tail];
+        DMA1_Channel4->CNTR = len;
+        DMA1_Channel4->CFGR |= DMA_CFGR1_EN;
+    }
+}
+
+/*********************************************************************
+ * @fn      DMA1_Channel4_IRQHandler
+ *
+ * @brief   Release the transferred data and send what was queued since.
+ *
+ * @return  None
+ */
+void DMA1_Channel4_IRQHandler(void)
+{
+    DMA1->INTFCR = DMA1_IT_GL4 | DMA1_IT_TC4 | DMA1_IT_HT4 | DMA1_IT_TE4;
+    Tx_Tail = (Tx_Tail + Tx_Len) & (PRINTF_BUF_SIZE - 1);
+    Tx_Start();
+}
+#endif
+
+/*********************************************************************
+ * @fn      USART_Printf_Flush
+ *
+ * @brief   Wait until all the buffered printf output has left the
+ *        USART. Call it before a baudrate change, a reset or sleep.
+ *
+ * @return  None
+ */
+void USART_Printf_Flush(void)
+{
+#if PRINTF_BUF_DMA
+    while(Tx_Len);
+    while(USART_GetFlagStatus(USART1, USART_FLAG_TC) == RESET);
+#endif
+}
+
+/*********************************************************************
+ * @fn      USART_Printf_Dropped
+ *
+ * @brief   Get the number of printf bytes dropped on a full buffer
+ *        (PRINTF_BUF_COUNT only).
+ *
+ * @return  Dropped bytes
+ */
+uint32_t USART_Printf_Dropped(void)
+{
+#if PRINTF_BUF_DMA && (PRINTF_BUF == PRINTF_BUF_COUNT)
+    return Tx_Dropped;
+#else
+    return 0;
+#endif
+}
+
 /*********************************************************************
  * @fn      _write
  *
@@ -205,11 +365,35 @@ int _write(int fd, char *buf, int size)
 
     } while (writeSize);
 
+#elif PRINTF_BUF_DMA
+    uint16_t head = Tx_Head;
+
+    for(i = 0; i < size; i++){
+#if (PRINTF_BUF == PRINTF_BUF_BLOCK)
+        while(TX_FULL(head)){
+            if(!Tx_Len) Tx_Start();   //Make sure what is queued is being sent
+        }
+#else
+        if(TX_FULL(head)){
+#if (PRINTF_BUF == PRINTF_BUF_COUNT)
+            Tx_Dropped += size - i;
+#endif
+            break;
+        }
+#endif
+        Tx_Buf[head] = buf[i];
+        head = (head + 1) & (PRINTF_BUF_SIZE - 1);
+        __asm volatile("" ::: "memory");   //Data before the index
+        Tx_Head = head;
+    }
+
+    if(!Tx_Len) Tx_Start();
+
 #else
 
     for(i = 0; i < size; i++){
-        while(USART_GetFlagStatus(USART1, USART_FLAG_TC) == RESET);
-        USART_SendData(USART1, *buf++);
+        while(USART_GetFlagStatus_Fast(USART1, USART_FLAG_TC) == RESET);
+        USART_SendData_Fast(USART1, *buf++);
     }
 
 
@@ -39,11 +39,40 @@
 #define SDI_PRINT   SDI_PR_CLOSE
 #endif
 
+/* UART Printf Buffer Definition */
+#define PRINTF_BUF_OFF     0  //Wait for the USART at each character
+#define PRINTF_BUF_DROP    1  //DMA in background, drop what does not fit
+#define PRINTF_BUF_BLOCK   2  //DMA in background, wait for room (not for use in interrupts)
+#define PRINTF_BUF_COUNT   3  //DMA in background, drop and count what does not fit
+
+#ifndef PRINTF_BUF
+#define PRINTF_BUF   PRINTF_BUF_OFF
+#endif
+
+#ifndef PRINTF_BUF_SIZE
+#define PRINTF_BUF_SIZE   128  //Power of 2, uses DMA1 channel 4
+#endif
+
+/* RAM Code Definition */
+#ifndef RAMFUNC_ENABLE
+#define RAMFUNC_ENABLE   1  //Functions marked RAMFUNC run from SRAM, without the flash wait state
+#endif
+
+#if RAMFUNC_ENABLE
+#define RAMFUNC   __attribute__((section(".ramfunc"), noinline))  //Copied to RAM by the startup code, see Link.ld
+#else
+#define RAMFUNC
+#endif
+
 void Delay_Init(void);
+void Delay_Tick(void);
+void Delay_Update(void);
 void Delay_Us(uint32_t n);
 void Delay_Ms(uint32_t n);
 void USART_Printf_Init(uint32_t baudrate);
 void SDI_Printf_Enable(void);
+void USART_Printf_Flush(void);
+uint32_t USART_Printf_Dropped(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,226 @@
+/*********************************************************************************
+ * File Name          : diskio_img.c
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : FatFs disk I/O over a disk image file (host build).
+ *******************************************************************************/
+#define _FILE_OFFSET_BITS 64
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ff.h"
+#include "diskio.h"
+#include "perf.h"
+#include "diskio_img.h"
+
+#define SECT    512
+
+static int Fd = -1;
+static int Flags;
+static BYTE *Map;               /* Mapping of the image (IMG_MMAP) */
+static uint64_t Size;           /* Image size in bytes */
+static uint32_t Block = 1;      /* Erase block size reported to f_mkfs */
+
+/*********************************************************************
+ * @fn      img_create
+ *
+ * @brief   Create (or truncate) a zero-filled image. The file is sparse,
+ *        so a large image costs no disk space until it is written.
+ *
+ * @param   path - Image file.
+ *          size - Size in bytes, rounded down to whole sectors.
+ *
+ * @return  0 or -1 with errno set
+ */
+int img_create(const char *path, uint64_t size)
+{
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+    if (fd < 0) return -1;
+    if (ftruncate(fd, (off_t)(size / SECT * SECT)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return close(fd);
+}
+
+/*********************************************************************
+ * @fn      img_open
+ *
+ * @brief   Attach an image file as drive 0.
+ *
+ * @param   path - Image file.
+ *          flags - IMG_xxx.
+ *
+ * @return  0 or -1 with errno set
+ */
+int img_open(const char *path, int flags)
+{
+    struct stat st;
+    int rdonly = flags & IMG_RDONLY;
+
+    img_close();
+    Fd = open(path, rdonly ? O_RDONLY : O_RDWR);
+    if (Fd < 0) return -1;
+    if (fstat(Fd, &st) != 0) goto fail;
+    Size = (uint64_t)st.st_size / SECT * SECT;
+    if (flags & IMG_MMAP) {
+        Map = mmap(0, Size, PROT_READ | (rdonly ? 0 : PROT_WRITE), MAP_SHARED, Fd, 0);
+        if (Map == MAP_FAILED) {
+            Map = 0;
+            goto fail;
+        }
+    }
+    Flags = flags;
+    return 0;
+
+fail:
+    close(Fd);
+    Fd = -1;
+    return -1;
+}
+
+/*********************************************************************
+ * @fn      img_close
+ *
+ * @brief   Detach the image, writing back the mapping if any.
+ *
+ * @return  none
+ */
+void img_close(void)
+{
+    if (Map) {
+        munmap(Map, Size);
+        Map = 0;
+    }
+    if (Fd >= 0) {
+        close(Fd);
+        Fd = -1;
+    }
+}
+
+/*********************************************************************
+ * @fn      img_set_block
+ *
+ * @brief   Set the erase block size returned by GET_BLOCK_SIZE, f_mkfs
+ *        aligns the data area to it.
+ *
+ * @param   sectors - Power of 2 from 1 to 32768.
+ *
+ * @return  none
+ */
+void img_set_block(uint32_t sectors)
+{
+    Block = sectors;
+}
+
+DSTATUS disk_status (
+    BYTE pdrv
+)
+{
+    if (pdrv || Fd < 0) return STA_NOINIT;
+    return (Flags & IMG_RDONLY) ? STA_PROTECT : 0;
+}
+
+DSTATUS disk_initialize (
+    BYTE pdrv
+)
+{
+    return disk_status(pdrv);
+}
+
+DRESULT disk_read (
+    BYTE pdrv,
+    BYTE *buff,
+    LBA_t sector,
+    UINT count
+)
+{
+    uint64_t ofs = (uint64_t)sector * SECT;
+    size_t len = (size_t)count * SECT;
+
+
+    PERF_BEGIN(PERF_DISK_READ);
+    if (pdrv || !count) return RES_PARERR;
+    if (Fd < 0) return RES_NOTRDY;
+    if (ofs + len > Size) return RES_PARERR;
+
+    if (Map) {
+        memcpy(buff, Map + ofs, len);
+    } else {
+        if (pread(Fd, buff, len, (off_t)ofs) != (ssize_t)len) return RES_ERROR;
+    }
+    return RES_OK;
+}
+
+DRESULT disk_write (
+    BYTE pdrv,
+    const BYTE *buff,
+    LBA_t sector,
+    UINT count
+)
+{
+    uint64_t ofs = (uint64_t)sector * SECT;
+    size_t len = (size_t)count * SECT;
+
+
+    PERF_BEGIN(PERF_DISK_WRITE);
+    if (pdrv || !count) return RES_PARERR;
+    if (Fd < 0) return RES_NOTRDY;
+    if (Flags & IMG_RDONLY) return RES_WRPRT;
+    if (ofs + len > Size) return RES_PARERR;
+
+    if (Map) {
+        memcpy(Map + ofs, buff, len);
+    } else {
+        if (pwrite(Fd, buff, len, (off_t)ofs) != (ssize_t)len) return RES_ERROR;
+    }
+    return RES_OK;
+}
+
+DRESULT disk_ioctl (
+    BYTE pdrv,
+    BYTE cmd,
+    void *buff
+)
+{
+    if (pdrv) return RES_PARERR;
+    if (Fd < 0) return RES_NOTRDY;
+
+    switch (cmd) {
+    case CTRL_SYNC :
+        if (Flags & IMG_FSYNC) {
+            if (Map ? msync(Map, Size, MS_SYNC) : fsync(Fd)) return RES_ERROR;
+        }
+        return RES_OK;
+
+    case GET_SECTOR_COUNT :
+        *(LBA_t*)buff = (LBA_t)(Size / SECT);
+        return RES_OK;
+
+    case GET_SECTOR_SIZE :
+        *(WORD*)buff = SECT;
+        return RES_OK;
+
+    case GET_BLOCK_SIZE :
+        *(DWORD*)buff = Block;
+        return RES_OK;
+
+    case CTRL_TRIM :
+        return RES_OK;
+    }
+    return RES_PARERR;
+}
+
+DWORD get_fattime (void)
+{
+    time_t t = time(0);
+    struct tm *tm = localtime(&t);
+
+    return (DWORD)(tm->tm_year - 80) << 25 | (DWORD)(tm->tm_mon + 1) << 21 | (DWORD)tm->tm_mday << 16
+         | (DWORD)tm->tm_hour << 11 | (DWORD)tm->tm_min << 5 | (DWORD)tm->tm_sec >> 1;
+}
@@ -0,0 +1,28 @@
+/*********************************************************************************
+ * File Name          : diskio_img.h
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : FatFs disk I/O over a disk image file (host build).
+ *********************************************************************************
+ * Drive 0 is a regular file holding a raw FAT volume, accessed either with
+ * pread/pwrite or through a shared mmap of the whole file. CTRL_SYNC does not
+ * reach the host disk unless IMG_FSYNC is given, so that benchmarks measure
+ * FatFs and not the host page cache writeback.
+ *******************************************************************************/
+#ifndef __DISKIO_IMG_H
+#define __DISKIO_IMG_H
+
+#include <stdint.h>
+
+/* Access mode */
+#define IMG_PREAD       0x00    /* pread/pwrite */
+#define IMG_MMAP        0x01    /* Shared mapping of the whole image */
+#define IMG_RDONLY      0x02    /* Open the image read-only */
+#define IMG_FSYNC       0x04    /* CTRL_SYNC does fsync/msync */
+
+int  img_create(const char *path, uint64_t size);
+int  img_open(const char *path, int flags);
+void img_close(void);
+void img_set_block(uint32_t sectors);
+
+#endif /* __DISKIO_IMG_H */
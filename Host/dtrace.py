@@ -0,0 +1,253 @@
+#!/usr/bin/env python3
+"""Decode a disk access trace (User/dtrace.h) and analyse the access pattern.
+
+Usage: dtrace.py [-i IMAGE] [-c SIZES] [-l] trace
+
+The trace is either the binary stream written by DTRACE_Flush or a console
+log holding DTRACE_Dump lines ("DTRC <hex>"), read from stdin if not given.
+The report covers seek locality, sequential run lengths, the re-read ratio
+and what an LRU write-back sector cache of each of SIZES sectors would have
+saved (CTRL_SYNC flushes it). With -i the accesses are replayed against the
+FAT volume in IMAGE to split them by region (boot/FAT/data) and to check
+that they stay inside the volume.
+"""
+
+import argparse
+import collections
+import struct
+import sys
+
+OPS = ('read', 'write', 'ioctl', 'lost')
+IOCTL = {0: 'CTRL_SYNC', 1: 'GET_SECTOR_COUNT', 2: 'GET_SECTOR_SIZE', 3: 'GET_BLOCK_SIZE', 4: 'CTRL_TRIM'}
+SYSTICK_HZ = 6000000        # HCLK/8 at 48MHz
+
+
+def read_stream(path):
+    f = sys.stdin.buffer if path is None else open(path, 'rb')
+    data = f.read()
+    if data[:2] == b'DT':
+        return data
+    out = bytearray()
+    for line in data.decode('latin-1').splitlines():
+        line = line.strip()
+        if line.startswith('DTRC ') and not line.startswith('DTRC end'):
+            if line[5:].startswith('445401'):   # Stream header, DTRACE_Start was called again
+                out = bytearray()
+            out += bytes.fromhex(line[5:])
+    if out[:2] != b'DT':
+        sys.exit('no trace found')
+    return bytes(out)
+
+
+def decode(data):
+    """Yield (time in SysTick counts, op, sector or ioctl code, count)."""
+    if data[2] != 1:
+        sys.exit('unknown trace version %d' % data[2])
+    tshift, pos, t, end = data[3], 4, 0, 0
+
+    def varint():
+        nonlocal pos
+        v = shift = 0
+        while True:
+            b = data[pos]
+            pos += 1
+            v |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                return v
+
+    while pos < len(data):
+        hdr = data[pos]
+        pos += 1
+        op = hdr & 3
+        t += varint() << tshift
+        if op == 2:
+            yield t, 'ioctl', data[pos], 0
+            pos += 1
+        elif op == 3:
+            yield t, 'lost', varint(), 0
+        else:
+            z = varint()
+            d = (z >> 1) ^ -(z & 1)
+            cnt = varint() if hdr & 4 else 1
+            sect = (end + d) & 0xFFFFFFFF
+            end = sect + cnt
+            yield t, OPS[op], sect, cnt
+
+
+def geometry(path):
+    """Regions of the FAT volume in an image as [(name, first, end)]."""
+    with open(path, 'rb') as f:
+        def sector(n):
+            f.seek(n * 512)
+            return f.read(512)
+        size = f.seek(0, 2) // 512
+        base, bs = 0, sector(0)
+        if bs[11:13] != b'\x00\x02':            # MBR: take the first partition
+            base = struct.unpack_from('<I', bs, 0x1C6)[0]
+            bs = sector(base)
+        csize, rsvd, nfats, nroot, tot16, fsz16, tot32, fsz32 = struct.unpack_from('<BHBHHxHxxxxxxxxII', bs, 13)
+        fsize = fsz16 or fsz32
+        fat = base + rsvd
+        data = fat + nfats * fsize + (nroot * 32 + 511) // 512
+        regions = [('mbr', 0, base), ('boot', base, fat)]
+        regions += [('fat%d' % (i + 1), fat + i * fsize, fat + (i + 1) * fsize) for i in range(nfats)]
+        if nroot:
+            regions.append(('rootdir', fat + nfats * fsize, data))
+        regions.append(('data', data, base + (tot16 or tot32)))
+        return regions, size
+
+
+def stats(values):
+    if not values:
+        return 'n=0'
+    v = sorted(values)
+    return 'n=%d mean=%.1f p50=%d p90=%d max=%d' % (
+        len(v), sum(v) / len(v), v[len(v) // 2], v[len(v) * 9 // 10], v[-1])
+
+
+def cache_whatif(recs, size):
+    """Disk sectors read and written below an LRU write-back cache of size sectors."""
+    lru = collections.OrderedDict()     # sector -> dirty
+    rd = wr = 0
+    for _, op, sect, cnt in recs:
+        if op == 'ioctl':
+            if sect == 0:               # CTRL_SYNC
+                wr += sum(lru.values())
+                for s in lru:
+                    lru[s] = False
+            continue
+        for s in range(sect, sect + cnt):
+            if s in lru:
+                lru.move_to_end(s)
+                if op == 'write':
+                    lru[s] = True
+                continue
+            if op == 'read':
+                rd += 1
+            lru[s] = op == 'write'
+            if len(lru) > size:
+                if lru.popitem(last=False)[1]:
+                    wr += 1
+    wr += sum(lru.values())
+    return rd, wr
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument('-i', '--image', help='FAT image to replay the accesses against')
+    ap.add_argument('-c', '--cache', default='1,2,4,8,16,32,64',
+                    help='cache sizes in sectors for the what-if (default 1,2,4,8,16,32,64)')
+    ap.add_argument('-l', '--list', action='store_true', help='also list the records')
+    ap.add_argument('trace', nargs='?')
+    args = ap.parse_args()
+
+    recs = list(decode(read_stream(args.trace)))
+    io = [r for r in recs if r[1] in ('read', 'write')]
+    if args.list:
+        for t, op, sect, cnt in recs:
+            if op == 'ioctl':
+                print('%12.1fus %-5s %s' % (t * 1e6 / SYSTICK_HZ, op, IOCTL.get(sect, sect)))
+            else:
+                print('%12.1fus %-5s %u+%u' % (t * 1e6 / SYSTICK_HZ, op, sect, cnt))
+        print()
+
+    span = recs[-1][0] if recs else 0
+    n = collections.Counter(r[1] for r in recs)
+    sects = collections.Counter()
+    for _, op, _, cnt in io:
+        sects[op] += cnt
+    print('records   %d over %.3fs (read %d, write %d, ioctl %d, lost %d)' % (
+        len(recs), span / SYSTICK_HZ, n['read'], n['write'], n['ioctl'],
+        sum(r[2] for r in recs if r[1] == 'lost')))
+    print('sectors   read %d, write %d' % (sects['read'], sects['write']))
+    if n['ioctl']:
+        print('ioctl     %s' % ', '.join('%s %d' % (IOCTL.get(k, k), v) for k, v in
+                                       sorted(collections.Counter(r[2] for r in recs if r[1] == 'ioctl').items())))
+
+    # Seek locality: distance from the end of the previous access
+    edges = (0, 1, 8, 64, 1024, 65536)
+    buckets = collections.Counter()
+    end = None
+    for _, op, sect, cnt in io:
+        if end is not None:
+            d = sect - end
+            for e in edges:
+                if abs(d) <= e:
+                    buckets[(e, d < 0)] += 1
+                    break
+            else:
+                buckets[(None, d < 0)] += 1
+        end = sect + cnt
+    print('\nseek distance from the previous access (sectors)')
+    for e in edges + (None,):
+        for back in ((False,) if e == 0 else (False, True)):
+            c = buckets[(e, back)]
+            if c:
+                label = 'sequential' if e == 0 else ('<=%s%d' % ('-' if back else '+', e)) if e is not None else \
+                        'far' + ('-' if back else '+')
+                print('  %-10s %7d %5.1f%%' % (label, c, 100.0 * c / (len(io) - 1)))
+
+    # Sequential runs: accesses of the same kind each starting where the previous one ended
+    runs = {'read': [], 'write': []}
+    cur = None
+    for _, op, sect, cnt in io:
+        if cur and cur[0] == op and cur[1] == sect:
+            cur[1], cur[2] = sect + cnt, cur[2] + cnt
+        else:
+            if cur:
+                runs[cur[0]].append(cur[2])
+            cur = [op, sect + cnt, cnt]
+    if cur:
+        runs[cur[0]].append(cur[2])
+    print('\nsequential runs (sectors)')
+    for op in ('read', 'write'):
+        print('  %-5s %s' % (op, stats(runs[op])))
+
+    # Re-reads: sectors read again that were read or written earlier in the trace
+    seen, rw, rr = set(), set(), 0
+    for _, op, sect, cnt in io:
+        for s in range(sect, sect + cnt):
+            if op == 'read' and s in seen:
+                rr += 1
+            seen.add(s)
+            if op == 'write':
+                rw.add(s)
+    print('\nre-read ratio %.1f%% (%d of %d sectors read), %d distinct sectors, %d written' % (
+        100.0 * rr / sects['read'] if sects['read'] else 0, rr, sects['read'], len(seen), len(rw)))
+
+    # Cache what-if
+    print('\nLRU write-back cache below FatFs (flushed on CTRL_SYNC)')
+    print('  %7s %10s %10s %8s %8s' % ('sectors', 'disk_rd', 'disk_wr', 'rd_saved', 'wr_saved'))
+    print('  %7s %10d %10d' % ('none', sects['read'], sects['write']))
+    for size in (int(s) for s in args.cache.split(',')):
+        rd, wr = cache_whatif(recs, size)
+        print('  %7d %10d %10d %7.1f%% %7.1f%%' % (
+            size, rd, wr, 100.0 * (sects['read'] - rd) / sects['read'] if sects['read'] else 0,
+            100.0 * (sects['write'] - wr) / sects['write'] if sects['write'] else 0))
+
+    # Replay against the volume
+    if args.image:
+        regions, size = geometry(args.image)
+        per = collections.Counter()
+        outside = 0
+        for _, op, sect, cnt in io:
+            for s in range(sect, sect + cnt):
+                if s >= size:
+                    outside += 1
+                    continue
+                for name, first, last in regions:
+                    if first <= s < last:
+                        per[(name, op)] += 1
+                        break
+        print('\nsectors by region of %s' % args.image)
+        for name, first, last in regions:
+            if per[(name, 'read')] or per[(name, 'write')]:
+                print('  %-8s %10d-%-10d read %7d  write %7d' % (
+                    name, first, last - 1, per[(name, 'read')], per[(name, 'write')]))
+        if outside:
+            print('  %d sectors beyond the end of the image' % outside)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,106 @@
+/*********************************************************************************
+ * File Name          : debug.h
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Stand-in for Debug/debug.h in the SD card emulator build.
+ *********************************************************************************
+ * Found ahead of the real headers on the include path, so User/diskio.c builds
+ * unmodified. SPI1, GPIOC and SysTick are emulated register blocks; every use
+ * of one of the macros is a register access and runs the model first (see
+ * sdemu.h), which is how a write to DATAR or BSHR gets noticed.
+ *******************************************************************************/
+#ifndef __DEBUG_H
+#define __DEBUG_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define __IO    volatile
+
+/* Register blocks, members named as in ch32v00x.h (all 32-bit wide here) */
+typedef struct
+{
+    __IO uint32_t CTLR1;
+    __IO uint32_t CTLR2;
+    __IO uint32_t STATR;
+    __IO uint32_t DATAR;
+} SPI_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t CFGLR;
+    __IO uint32_t INDR;
+    __IO uint32_t OUTDR;
+    __IO uint32_t BSHR;
+    __IO uint32_t BCR;
+    __IO uint32_t LCKR;
+} GPIO_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t CTLR;
+    __IO uint32_t SR;
+    __IO uint32_t CNT;
+    __IO uint32_t CMP;
+} SysTick_Type;
+
+extern SPI_TypeDef  Emu_SPI1;
+extern GPIO_TypeDef Emu_GPIOC;
+extern SysTick_Type Emu_SysTick;
+
+extern uint32_t SystemCoreClock;
+
+void emu_sync(void);
+
+#define SPI1        (emu_sync(), &Emu_SPI1)
+#define GPIOC       (emu_sync(), &Emu_GPIOC)
+#define SysTick     (emu_sync(), &Emu_SysTick)
+
+#define RAMFUNC                         /* No flash wait state to avoid on the host */
+
+/* Bits used by the driver, values from ch32v00x.h / ch32v00x_spi.h / ch32v00x_gpio.h */
+#define SPI_I2S_FLAG_RXNE               ((uint16_t)0x0001)
+#define SPI_I2S_FLAG_TXE                ((uint16_t)0x0002)
+#define SPI_I2S_FLAG_BSY                ((uint16_t)0x0080)
+#define SPI_CTLR1_BR                    ((uint16_t)0x0038)
+#define SPI_BaudRatePrescaler_2         ((uint16_t)0x0000)
+#define SPI_BaudRatePrescaler_4         ((uint16_t)0x0008)
+#define SPI_BaudRatePrescaler_8         ((uint16_t)0x0010)
+#define SPI_BaudRatePrescaler_16        ((uint16_t)0x0018)
+#define SPI_BaudRatePrescaler_32        ((uint16_t)0x0020)
+#define SPI_BaudRatePrescaler_64        ((uint16_t)0x0028)
+#define SPI_BaudRatePrescaler_128       ((uint16_t)0x0030)
+#define SPI_BaudRatePrescaler_256       ((uint16_t)0x0038)
+#define GPIO_Pin_3                      ((uint16_t)0x0008)
+
+/*
+ * The ch32v00x_fast.h functions used by the driver, same register sequences.
+ * The pointer argument is evaluated once, so each access runs the model
+ * again through EMU_REG.
+ */
+#define EMU_REG(p)      (emu_sync(), (p))
+
+static inline void GPIO_SetBits_Fast(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    EMU_REG(GPIOx)->BSHR = GPIO_Pin;
+}
+
+static inline void GPIO_ResetBits_Fast(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    EMU_REG(GPIOx)->BCR = GPIO_Pin;
+}
+
+static inline uint8_t SPI_Xchg_Fast(SPI_TypeDef *SPIx, uint8_t Data)
+{
+    uint8_t ret;
+
+    while(EMU_REG(SPIx)->STATR & SPI_I2S_FLAG_BSY);
+    EMU_REG(SPIx)->DATAR = Data;
+    while(!(EMU_REG(SPIx)->STATR & SPI_I2S_FLAG_TXE));
+    while(!(EMU_REG(SPIx)->STATR & SPI_I2S_FLAG_RXNE));
+    ret = (uint8_t)EMU_REG(SPIx)->DATAR;
+    while(EMU_REG(SPIx)->STATR & SPI_I2S_FLAG_BSY);
+    return ret;
+}
+
+#endif /* __DEBUG_H */
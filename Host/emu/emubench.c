@@ -0,0 +1,170 @@
+/*********************************************************************************
+ * File Name          : emubench.c
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : FatFs and User/diskio.c on the emulated SD card.
+ *********************************************************************************
+ * emubench [options] IMAGE
+ *
+ *   -a CYCLES     HCLK cycles per register access (default 2)
+ *   -n BYTES      Command response delay NCR (default 1)
+ *   -i US         Card initialization time (default 20000)
+ *   -r US         Read access time per block (default 100)
+ *   -w US         Write busy time per block (default 250)
+ *   -t US         Busy time after CMD12 / StopTran (default 100)
+ *   -g N:US       Every Nth written block is busy for US instead
+ *   -b            SDSC card (byte addressing) instead of SDHC
+ *   -s KB         Size of the test file (default 256)
+ *   -c BYTES      f_write/f_read size (default 4096)
+ *   -T            Print the disk access trace (DTRC lines, see Host/dtrace.py)
+ *
+ * IMAGE must hold a FAT volume (ffhost IMAGE mkfs MB). The test file is
+ * written, read back and removed. Each phase prints one line of key=value
+ * pairs; times are emulated, so the output only changes with the code.
+ *******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ff.h"
+#include "diskio.h"
+#include "perf.h"
+#include "dtrace.h"
+#include "sdemu.h"
+
+#define FILE_NAME   "EMUBENCH.BIN"
+
+static FATFS Fs;
+static BYTE Buf[32768];
+
+static uint64_t T0;
+static EMU_StatTypeDef S0;
+
+static void phase_begin(void)
+{
+    T0 = Emu_Cycles;
+    S0 = Emu_Stat;
+}
+
+static void phase_end(const char *name, uint32_t bytes, FRESULT res)
+{
+    uint64_t c = Emu_Cycles - T0;
+
+    printf("emu phase=%s res=%d bytes=%u cycles=%llu us=%llu kBps=%llu spi_bytes=%llu busy_bytes=%llu"
+           " accesses=%llu cmds=%u rd_blocks=%u wr_blocks=%u\n",
+           name, (int)res, (unsigned)bytes, (unsigned long long)c,
+           (unsigned long long)(c / (EMU_HCLK / 1000000u)),
+           (unsigned long long)(c ? (uint64_t)bytes * EMU_HCLK / 1000u / c : 0),
+           (unsigned long long)(Emu_Stat.SpiBytes - S0.SpiBytes),
+           (unsigned long long)(Emu_Stat.BusyBytes - S0.BusyBytes),
+           (unsigned long long)(Emu_Stat.Accesses - S0.Accesses),
+           (unsigned)(Emu_Stat.Cmds - S0.Cmds),
+           (unsigned)(Emu_Stat.RdBlocks - S0.RdBlocks),
+           (unsigned)(Emu_Stat.WrBlocks - S0.WrBlocks));
+}
+
+#if DSTAT_ENABLE
+static void dstat_dump(void)
+{
+    static const char *const Cls[DSTAT_CLASSES] = { "read1", "readn", "write1", "writen", "busy" };
+    DSTAT st;
+    int c, b;
+
+    if (disk_ioctl(0, MMC_GET_DSTAT, &st) != RES_OK) return;
+    printf("dstat rd_sect=%u wr_sect=%u spi_bytes=%u rd_errors=%u wr_errors=%u busy_timeouts=%u"
+           " token_timeouts=%u token_errors=%u cmd_timeouts=%u wr_rejects=%u init_retries=%u\n",
+           (unsigned)st.rd_sect, (unsigned)st.wr_sect, (unsigned)st.spi_bytes, st.rd_errors, st.wr_errors,
+           st.busy_timeouts, st.token_timeouts, st.token_errors, st.cmd_timeouts, st.wr_rejects, st.init_retries);
+    for (c = 0; c < DSTAT_CLASSES; c++) {
+        printf("dstat hist=%s", Cls[c]);
+        for (b = 0; b < DSTAT_BUCKETS; b++) printf(" %u", st.hist[c][b]);
+        printf("\n");
+    }
+}
+#endif
+
+static int usage(void)
+{
+    fprintf(stderr, "usage: emubench [-a CYCLES] [-n BYTES] [-i US] [-r US] [-w US] [-t US] [-g N:US] [-b]"
+                    " [-s KB] [-c BYTES] [-T] IMAGE\n");
+    return 2;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t size = 256 * 1024, chunk = 4096, done, n;
+    UINT bw;
+    FIL fil;
+    FRESULT res;
+    char *p;
+    int trace = 0;
+
+    for (argc--, argv++; argc > 1 && argv[0][0] == '-'; argc--, argv++) {
+        switch (argv[0][1]) {
+        case 'b': Emu_Cfg.sdhc = 0; continue;
+        case 'T': trace = 1; continue;
+        case 'a': Emu_Cfg.access_cycles = (uint32_t)strtoul(argv[1], 0, 0); break;
+        case 'n': Emu_Cfg.ncr = (uint32_t)strtoul(argv[1], 0, 0); break;
+        case 'i': Emu_Cfg.init_us = (uint32_t)strtoul(argv[1], 0, 0); break;
+        case 'r': Emu_Cfg.read_us = (uint32_t)strtoul(argv[1], 0, 0); break;
+        case 'w': Emu_Cfg.write_us = (uint32_t)strtoul(argv[1], 0, 0); break;
+        case 't': Emu_Cfg.stop_us = (uint32_t)strtoul(argv[1], 0, 0); break;
+        case 'g':
+            Emu_Cfg.slow_every = (uint32_t)strtoul(argv[1], &p, 0);
+            Emu_Cfg.slow_us = (*p == ':') ? (uint32_t)strtoul(p + 1, 0, 0) : 0;
+            break;
+        case 's': size = (uint32_t)strtoul(argv[1], 0, 0) * 1024; break;
+        case 'c': chunk = (uint32_t)strtoul(argv[1], 0, 0); break;
+        default: return usage();
+        }
+        argc--, argv++;
+    }
+    if (argc != 1 || chunk == 0 || chunk > sizeof Buf || Emu_Cfg.ncr < 1 || Emu_Cfg.ncr > 8) return usage();
+    if (emu_open(argv[0]) != 0) {
+        perror(argv[0]);
+        return 1;
+    }
+    for (n = 0; n < sizeof Buf; n++) Buf[n] = (BYTE)(n * 7 + 1);
+
+    if (trace) DTRACE_Start();
+    phase_begin();
+    res = f_mount(&Fs, "", 1);
+    phase_end("mount", 0, res);
+    if (res) return 1;
+#if DSTAT_ENABLE
+    disk_ioctl(0, MMC_RESET_DSTAT, 0);
+#endif
+
+    phase_begin();
+    res = f_open(&fil, FILE_NAME, FA_CREATE_ALWAYS | FA_WRITE);
+    for (done = 0; res == FR_OK && done < size; done += bw) {
+        n = (size - done < chunk) ? size - done : chunk;
+        res = f_write(&fil, Buf, n, &bw);
+        if (res == FR_OK && bw != n) res = FR_DENIED;
+    }
+    if (res == FR_OK) res = f_close(&fil);
+    phase_end("write", done, res);
+
+    phase_begin();
+    if (res == FR_OK) res = f_open(&fil, FILE_NAME, FA_READ);
+    for (done = 0; res == FR_OK && done < size; done += bw) {
+        n = (size - done < chunk) ? size - done : chunk;
+        res = f_read(&fil, Buf, n, &bw);
+        if (res == FR_OK && bw != n) res = FR_INT_ERR;
+        while (res == FR_OK && n--) {
+            if (Buf[n] != (BYTE)(n * 7 + 1)) res = FR_INT_ERR;     /* Data read back differs */
+        }
+    }
+    if (res == FR_OK) res = f_close(&fil);
+    phase_end("read", done, res);
+
+#if DSTAT_ENABLE
+    dstat_dump();
+#endif
+    f_unlink(FILE_NAME);
+    f_unmount("");
+    PERF_Dump();
+    if (trace) DTRACE_Dump();
+    emu_close();
+    return res ? 1 : 0;
+}
@@ -0,0 +1,496 @@
+/*********************************************************************************
+ * File Name          : sdemu.c
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Register-level SPI1/GPIOC/SysTick model with an SD card
+ *                      in SPI mode behind it, backed by a disk image file.
+ *******************************************************************************/
+#define _FILE_OFFSET_BITS 64
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "debug.h"
+#include "ff.h"
+#include "diskio.h"
+#include "sdemu.h"
+
+#define SECT        512
+#define US(us)      ((uint64_t)(us) * (EMU_HCLK / 1000000u))
+#define NO_SECT     0xFFFFFFFFu
+
+/* DATAR holds the received byte under this marker until the driver writes it */
+#define DATAR_MARK  0xA5A50000u
+
+/* Card states */
+#define C_OFF       0       /* Not in SPI mode, waits for CMD0 */
+#define C_IDLE      1       /* In idle state, initializing */
+#define C_READY     2       /* Ready for data transfer */
+
+/* R1 bits */
+#define R1_IDLE     0x01
+#define R1_ILLEGAL  0x04
+#define R1_ADDRESS  0x20
+#define R1_PARAM    0x40
+
+SPI_TypeDef  Emu_SPI1;
+GPIO_TypeDef Emu_GPIOC;
+SysTick_Type Emu_SysTick;
+uint32_t SystemCoreClock = 48000000;    /* SysTick and SPI timings assume it */
+
+EMU_CfgTypeDef Emu_Cfg = {
+    2,          /* access_cycles */
+    1,          /* ncr */
+    20000,      /* init_us */
+    100,        /* read_us */
+    250,        /* write_us */
+    100,        /* stop_us */
+    0, 0,       /* slow_every, slow_us */
+    8192,       /* au_sectors (4MiB) */
+    1           /* sdhc */
+};
+EMU_StatTypeDef Emu_Stat;
+uint64_t Emu_Cycles;
+
+static int Fd = -1;
+static uint32_t Sectors;        /* Image size in sectors */
+
+/* Bus */
+static uint64_t Tick;           /* Next 1ms SysTick interrupt */
+static uint64_t SpiDone;        /* End of the byte in the shift register */
+static uint8_t Selected;        /* CS# low */
+
+/* Card */
+static uint8_t State;
+static uint8_t AppCmd;          /* Previous command was CMD55 */
+static uint64_t InitDone;       /* Time ACMD41 starts to report ready (0: not started) */
+static uint8_t Cmd[6], CmdLen;  /* Command being received */
+static uint8_t Out[SECT + 32];  /* Bytes to send: response, data packet */
+static uint16_t OutPos, OutLen;
+static uint16_t HoldPos;        /* Out[HoldPos] is not sent before HoldUntil (access time) */
+static uint64_t HoldUntil;
+static uint64_t Busy;           /* DO held low until then */
+static uint64_t BusyAfter;      /* Busy time to start once Out has been sent */
+static uint32_t RdNext;         /* Next sector of CMD18 */
+static uint8_t WrMode;          /* 0, 24 or 25: waiting for data packets of that command */
+static uint32_t WrSect;         /* Sector of the next data packet */
+static int WrLen;               /* Bytes of the data packet received, -1: waiting for the token */
+static uint32_t WrCount;        /* Blocks written, for slow_every */
+static uint8_t Blk[SECT + 2];
+
+
+static void out_reset(void)
+{
+    OutPos = OutLen = 0;
+    HoldPos = 0xFFFF;
+}
+
+static void out_put(uint8_t b)
+{
+    Out[OutLen++] = b;
+}
+
+static void out_block(const uint8_t *p, uint16_t n, uint64_t until)
+{
+    HoldPos = OutLen;
+    HoldUntil = until;
+    out_put(0xFE);                  /* Data token */
+    memcpy(&Out[OutLen], p, n);
+    OutLen += n;
+    out_put(0xFF);                  /* CRC16 (not computed) */
+    out_put(0xFF);
+}
+
+static void respond(uint8_t r1)
+{
+    uint32_t n;
+
+    out_reset();
+    for (n = Emu_Cfg.ncr; n; n--) out_put(0xFF);
+    out_put(r1);
+}
+
+static int sect_read(uint32_t sect, uint8_t *p)
+{
+    return pread(Fd, p, SECT, (off_t)sect * SECT) == SECT;
+}
+
+static int sect_write(uint32_t sect, const uint8_t *p)
+{
+    return pwrite(Fd, p, SECT, (off_t)sect * SECT) == SECT;
+}
+
+/* Sector addressed by a data command, NO_SECT if out of range */
+static uint32_t address(uint32_t arg)
+{
+    if (!Emu_Cfg.sdhc) {
+        if (arg % SECT) return NO_SECT;
+        arg /= SECT;
+    }
+    return arg < Sectors ? arg : NO_SECT;
+}
+
+static void read_csd(uint8_t *csd)
+{
+    uint32_t c;
+
+    memset(csd, 0, 16);
+    csd[3] = 0x32;                  /* TRAN_SPEED 25MHz */
+    csd[4] = 0x5B;                  /* CCC */
+    csd[5] = 0x59;                  /* CCC, READ_BL_LEN 9 */
+    csd[12] = 0x0A;                 /* R2W_FACTOR, WRITE_BL_LEN 9 */
+    csd[13] = 0x40;
+    csd[15] = 0x01;
+    if (Emu_Cfg.sdhc) {             /* CSD 2.0: C_SIZE in 512KiB */
+        c = Sectors / 1024 - 1;
+        csd[0] = 0x40;
+        csd[1] = 0x0E;
+        csd[7] = (uint8_t)(c >> 16) & 0x3F;
+        csd[8] = (uint8_t)(c >> 8);
+        csd[9] = (uint8_t)c;
+        csd[10] = 0x7F;
+        csd[11] = 0x80;
+    } else {                        /* CSD 1.0: C_SIZE_MULT 7, up to 1GiB */
+        c = (Sectors < 4096 * 512 ? Sectors : 4096 * 512) / 512 - 1;
+        csd[1] = 0x26;
+        csd[6] = 0x80 | (uint8_t)(c >> 10);
+        csd[7] = (uint8_t)(c >> 2);
+        csd[8] = (uint8_t)(c << 6);
+        csd[9] = 0x03;              /* C_SIZE_MULT[2:1] */
+        csd[10] = 0xBF;             /* C_SIZE_MULT[0], SECTOR_SIZE 127 */
+        csd[11] = 0x80;
+    }
+}
+
+static void read_cid(uint8_t *cid)
+{
+    static const uint8_t Cid[16] = {
+        0x00, 'E', 'M', 'S', 'D', 'E', 'M', 'U', 0x10, 0x00, 0x00, 0x00, 0x01, 0x01, 0xAA, 0x01
+    };
+
+    memcpy(cid, Cid, 16);
+}
+
+static void read_sdstat(uint8_t *st)
+{
+    uint8_t n;
+
+    memset(st, 0, 64);
+    for (n = 0; n < 15 && (16u << n) < Emu_Cfg.au_sectors; n++) ;
+    st[8] = 4;                      /* SPEED_CLASS: class 10 */
+    st[10] = n << 4;                /* AU_SIZE */
+}
+
+static void command(uint64_t t)
+{
+    uint8_t idx = Cmd[0] & 0x3F, acmd = AppCmd, r1, reg[64];
+    uint32_t arg = (uint32_t)Cmd[1] << 24 | (uint32_t)Cmd[2] << 16 | (uint32_t)Cmd[3] << 8 | Cmd[4];
+    uint32_t sect;
+
+    Emu_Stat.Cmds++;
+    AppCmd = 0;
+    WrMode = 0;
+    if (State == C_OFF && idx != 0) return;     /* No response before CMD0 */
+    if (idx != 12) RdNext = NO_SECT;
+
+    r1 = (State == C_IDLE) ? R1_IDLE : 0;
+    switch (idx) {
+    case 0 :    /* GO_IDLE_STATE */
+        State = C_IDLE;
+        InitDone = 0;
+        respond(R1_IDLE);
+        return;
+
+    case 8 :    /* SEND_IF_COND: R7 */
+        respond(r1);
+        out_put(0x00);
+        out_put(0x00);
+        out_put((uint8_t)(arg >> 8) & 0x0F);
+        out_put((uint8_t)arg);
+        return;
+
+    case 55 :   /* APP_CMD */
+        AppCmd = 1;
+        respond(r1);
+        return;
+
+    case 41 :   /* ACMD41 SD_SEND_OP_COND */
+        if (!acmd) break;
+        if (!InitDone) InitDone = t + US(Emu_Cfg.init_us);
+        if (t >= InitDone) State = C_READY;
+        respond(State == C_IDLE ? R1_IDLE : 0);
+        return;
+
+    case 58 :   /* READ_OCR: R3 */
+        respond(r1);
+        out_put(State != C_READY ? 0x00 : Emu_Cfg.sdhc ? 0xC0 : 0x80);   /* Power up status, CCS */
+        out_put(0xFF);
+        out_put(0x80);
+        out_put(0x00);
+        return;
+
+    case 12 :   /* STOP_TRANSMISSION: R1b */
+        RdNext = NO_SECT;
+        respond(r1);
+        BusyAfter = US(Emu_Cfg.stop_us);
+        return;
+
+    case 13 :   /* SEND_STATUS / ACMD13 SD_STATUS: R2 */
+        respond(r1);
+        out_put(0x00);
+        if (acmd && State == C_READY) {
+            read_sdstat(reg);
+            out_block(reg, 64, t);
+        }
+        return;
+
+    case 16 :   /* SET_BLOCKLEN */
+        respond(arg == SECT ? r1 : r1 | R1_PARAM);
+        return;
+
+    case 23 :   /* ACMD23 SET_WR_BLK_ERASE_COUNT */
+        respond(acmd ? r1 : r1 | R1_ILLEGAL);
+        return;
+    }
+
+    if (State != C_READY) {
+        respond(r1 | R1_ILLEGAL);
+        return;
+    }
+
+    switch (idx) {
+    case 9 :    /* SEND_CSD */
+    case 10 :   /* SEND_CID */
+        respond(0);
+        if (idx == 9) read_csd(reg); else read_cid(reg);
+        out_block(reg, 16, t);
+        return;
+
+    case 17 :   /* READ_SINGLE_BLOCK */
+    case 18 :   /* READ_MULTIPLE_BLOCK */
+        sect = address(arg);
+        if (sect == NO_SECT) {
+            respond(Emu_Cfg.sdhc ? R1_PARAM : R1_ADDRESS);
+            return;
+        }
+        respond(0);
+        if (!sect_read(sect, Blk)) {
+            out_put(0x01);          /* Error token: error */
+            return;
+        }
+        out_block(Blk, SECT, t + US(Emu_Cfg.read_us));
+        Emu_Stat.RdBlocks++;
+        if (idx == 18) RdNext = sect + 1;
+        return;
+
+    case 24 :   /* WRITE_BLOCK */
+    case 25 :   /* WRITE_MULTIPLE_BLOCK */
+        sect = address(arg);
+        if (sect == NO_SECT) {
+            respond(Emu_Cfg.sdhc ? R1_PARAM : R1_ADDRESS);
+            return;
+        }
+        respond(0);
+        WrMode = idx;
+        WrSect = sect;
+        WrLen = -1;
+        return;
+    }
+
+    respond(r1 | R1_ILLEGAL);
+}
+
+/* Next packet of CMD18 once the previous one has been sent */
+static void next_block(uint64_t t)
+{
+    out_reset();
+    if (RdNext >= Sectors || !sect_read(RdNext, Blk)) {
+        out_put(RdNext >= Sectors ? 0x08 : 0x01);  /* Error token: out of range / error */
+        RdNext = NO_SECT;
+        return;
+    }
+    out_block(Blk, SECT, t + US(Emu_Cfg.read_us));
+    Emu_Stat.RdBlocks++;
+    RdNext++;
+}
+
+/* DO for one byte time starting at t */
+static uint8_t card_out(uint64_t t)
+{
+    uint8_t b;
+
+    if (t < Busy) {
+        Emu_Stat.BusyBytes++;
+        return 0x00;
+    }
+    if (OutPos == OutLen && RdNext != NO_SECT) next_block(t);
+    if (OutPos == OutLen) return 0xFF;
+    if (OutPos == HoldPos && t < HoldUntil) return 0xFF;
+
+    b = Out[OutPos++];
+    if (OutPos == OutLen && BusyAfter) {
+        Busy = t + BusyAfter;
+        BusyAfter = 0;
+    }
+    return b;
+}
+
+/* DI for one byte time starting at t */
+static void card_in(uint8_t b, uint64_t t)
+{
+    uint32_t us;
+
+    if (WrMode && WrLen >= 0) {         /* Data packet */
+        Blk[WrLen++] = b;
+        if (WrLen < SECT + 2) return;
+        out_reset();
+        if (WrSect < Sectors && sect_write(WrSect, Blk)) {
+            out_put(0xE5);              /* Data accepted */
+            Emu_Stat.WrBlocks++;
+            us = (Emu_Cfg.slow_every && ++WrCount % Emu_Cfg.slow_every == 0) ? Emu_Cfg.slow_us : Emu_Cfg.write_us;
+            BusyAfter = US(us);
+        } else {
+            out_put(0xED);              /* Write error */
+            WrMode = 0;
+        }
+        WrSect++;
+        WrLen = -1;
+        if (WrMode == 24) WrMode = 0;
+        return;
+    }
+
+    if (WrMode && CmdLen == 0) {        /* Data token */
+        if (b == (WrMode == 24 ? 0xFE : 0xFC)) {
+            WrLen = 0;
+            return;
+        }
+        if (b == 0xFD && WrMode == 25) {    /* StopTran */
+            WrMode = 0;
+            Busy = t + US(Emu_Cfg.stop_us);
+            return;
+        }
+    }
+
+    if (CmdLen == 0 && (b & 0xC0) != 0x40) return;
+    Cmd[CmdLen++] = b;
+    if (CmdLen == 6) {
+        CmdLen = 0;
+        command(t);
+    }
+}
+
+/*********************************************************************
+ * @fn      emu_sync
+ *
+ * @brief   Runs the model up to the current register access: charges
+ *        the access, raises the SysTick interrupt, applies CS# changes
+ *        and clocks a byte written to DATAR through the card.
+ *
+ * @return  none
+ */
+void emu_sync(void)
+{
+    uint32_t v;
+    uint64_t start;
+    uint8_t cs;
+
+    Emu_Cycles += Emu_Cfg.access_cycles ? Emu_Cfg.access_cycles : 1;
+    Emu_Stat.Accesses++;
+
+    /* SysTick: HCLK/8 counter and the 1ms interrupt */
+    Emu_SysTick.CNT = (uint32_t)(Emu_Cycles / 8);
+    while (Emu_Cycles >= Tick) {
+        Tick += EMU_HCLK / 1000;
+        disk_timerproc();
+    }
+
+    /* GPIOC: BSHR and BCR read as zero */
+    if ((v = Emu_GPIOC.BSHR) != 0) {
+        Emu_GPIOC.OUTDR = (Emu_GPIOC.OUTDR | (v & 0xFFFF)) & ~(v >> 16);
+        Emu_GPIOC.BSHR = 0;
+    }
+    if ((v = Emu_GPIOC.BCR) != 0) {
+        Emu_GPIOC.OUTDR &= ~v;
+        Emu_GPIOC.BCR = 0;
+    }
+    cs = !(Emu_GPIOC.OUTDR & GPIO_Pin_3);
+    if (cs != Selected) {
+        Selected = cs;
+        CmdLen = 0;
+    }
+
+    /* SPI1: 8 SCLK periods of PCLK / (2 << BR) per byte */
+    if ((Emu_SPI1.DATAR & 0xFFFF0000u) != DATAR_MARK) {
+        start = Emu_Cycles > SpiDone ? Emu_Cycles : SpiDone;
+        SpiDone = start + (16u << ((Emu_SPI1.CTLR1 & SPI_CTLR1_BR) >> 3));
+        v = 0xFF;
+        if (Selected) {
+            Emu_Stat.SpiBytes++;
+            v = card_out(start);
+            card_in((uint8_t)Emu_SPI1.DATAR, start);
+        }
+        Emu_SPI1.DATAR = DATAR_MARK | v;
+    }
+    Emu_SPI1.STATR = SPI_I2S_FLAG_TXE | (Emu_Cycles < SpiDone ? SPI_I2S_FLAG_BSY : SPI_I2S_FLAG_RXNE);
+}
+
+/*********************************************************************
+ * @fn      emu_open
+ *
+ * @brief   Inserts a card backed by an image file and resets the model
+ *        to power-on state (CS# high, SCLK at PCLK/128, time 0).
+ *
+ * @param   path - Image file, a multiple of 512KiB for an SDHC card.
+ *
+ * @return  0 or -1 with errno set
+ */
+int emu_open(const char *path)
+{
+    struct stat st;
+
+    emu_close();
+    Fd = open(path, O_RDWR);
+    if (Fd < 0) return -1;
+    if (fstat(Fd, &st) != 0) {
+        emu_close();
+        return -1;
+    }
+    Sectors = (uint32_t)(st.st_size / SECT);
+
+    Emu_Cycles = 0;
+    memset(&Emu_Stat, 0, sizeof Emu_Stat);
+    Tick = EMU_HCLK / 1000;
+    SpiDone = 0;
+    Emu_GPIOC.OUTDR = GPIO_Pin_3;
+    Emu_SPI1.CTLR1 = SPI_BaudRatePrescaler_128;
+    Emu_SPI1.DATAR = DATAR_MARK | 0xFF;
+    Emu_SPI1.STATR = SPI_I2S_FLAG_TXE;
+    Selected = 0;
+
+    State = C_OFF;
+    AppCmd = 0;
+    InitDone = 0;
+    CmdLen = 0;
+    out_reset();
+    Busy = BusyAfter = 0;
+    RdNext = NO_SECT;
+    WrMode = 0;
+    WrCount = 0;
+    return 0;
+}
+
+/*********************************************************************
+ * @fn      emu_close
+ *
+ * @brief   Removes the card.
+ *
+ * @return  none
+ */
+void emu_close(void)
+{
+    if (Fd >= 0) {
+        close(Fd);
+        Fd = -1;
+    }
+}
@@ -0,0 +1,60 @@
+/*********************************************************************************
+ * File Name          : sdemu.h
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Register-level SPI1/GPIOC/SysTick model with an SD card
+ *                      in SPI mode behind it, backed by a disk image file.
+ *********************************************************************************
+ * Time is counted in HCLK cycles (48MHz). Every register access costs
+ * access_cycles (at least 1, so that polling loops make progress); an SPI byte
+ * takes 8 SCLK periods at the prescaler in CTLR1. BSY/TXE/RXNE follow from that,
+ * SysTick->CNT runs at HCLK/8 and disk_timerproc() is called every 1ms of
+ * emulated time, as SysTick_Handler does on the target.
+ *
+ * The card (CS# on PC3) answers CMD0/8/9/10/12/16/17/18/24/25/55/58 and
+ * ACMD13/23/41 with the R1/R1b/R2/R3/R7 responses of the SD specification.
+ * Read blocks are preceded by read_us of access time, written blocks are
+ * followed by write_us of busy (slow_us on every slow_every'th block), CMD12
+ * and the StopTran token by stop_us. CRCs are neither sent nor checked.
+ *******************************************************************************/
+#ifndef __SDEMU_H
+#define __SDEMU_H
+
+#include <stdint.h>
+
+#define EMU_HCLK        48000000u
+
+/* Model parameters */
+typedef struct
+{
+    uint32_t access_cycles; /* HCLK cycles per register access */
+    uint32_t ncr;           /* Bytes from the end of a command to its response (1..8) */
+    uint32_t init_us;       /* Time ACMD41 reports idle after the first ACMD41 */
+    uint32_t read_us;       /* Access time before each read data token */
+    uint32_t write_us;      /* Busy time after each written block */
+    uint32_t stop_us;       /* Busy time after CMD12 or the StopTran token */
+    uint32_t slow_every;    /* Every slow_every'th written block (0: none)... */
+    uint32_t slow_us;       /* ...is busy for slow_us instead (erase / GC stall) */
+    uint32_t au_sectors;    /* Allocation unit reported by ACMD13 (16 << n) */
+    uint8_t  sdhc;          /* 1: SDHC (block addressing), 0: SDSC v2 (byte addressing) */
+} EMU_CfgTypeDef;
+
+/* Counters since emu_open */
+typedef struct
+{
+    uint64_t Accesses;      /* Register accesses */
+    uint64_t SpiBytes;      /* Bytes exchanged with CS# low */
+    uint64_t BusyBytes;     /* Bytes answered with busy (0x00) */
+    uint32_t Cmds;          /* Commands received */
+    uint32_t RdBlocks;      /* 512-byte blocks read */
+    uint32_t WrBlocks;      /* 512-byte blocks written */
+} EMU_StatTypeDef;
+
+extern EMU_CfgTypeDef  Emu_Cfg;
+extern EMU_StatTypeDef Emu_Stat;
+extern uint64_t        Emu_Cycles;
+
+int  emu_open(const char *path);
+void emu_close(void);
+
+#endif /* __SDEMU_H */
@@ -0,0 +1,336 @@
+/*********************************************************************************
+ * File Name          : ffbench.c
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Micro-benchmarks of FatFs internals on host disk images.
+ *********************************************************************************
+ * ffbench [-q] [-k] [-d DIR] [GROUP...]
+ *
+ *   -q            Quick run (smaller counts, no 32GB volume), for CI
+ *   -k            Keep the images
+ *   -d DIR        Directory for the images (default /tmp), must allow sparse files
+ *
+ *   fat           get_fat/put_fat, sequential and random clusters
+ *   chain         create_chain on an empty, half-full and fragmented volume
+ *   dir           Lookups (dir_find through f_stat) in directories of 10..10k entries
+ *   getfree       f_getfree on 4GB and 32GB volumes, from FSInfo and by FAT scan
+ *   rw            Sequential and random f_read/f_write, 1B to 64KB records
+ *
+ * ff.c is included in this file, so that the static functions can be called,
+ * and is built with the project ffconf.h. Images are accessed through mmap,
+ * which leaves the FatFs code as the cost being measured. Each result is one
+ * line of key=value pairs starting with "bench=".
+ *******************************************************************************/
+#include "ff.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "diskio_img.h"
+
+static FATFS Vol;
+static BYTE Work[65536];
+static const char *Dir = "/tmp";
+static int Quick, Keep;
+static char Path[512];
+static uint32_t Seed = 1;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t rnd(void)       /* xorshift32, reproducible between runs */
+{
+    Seed ^= Seed << 13;
+    Seed ^= Seed >> 17;
+    Seed ^= Seed << 5;
+    return Seed;
+}
+
+static void check(const char *what, FRESULT res)
+{
+    if (res != FR_OK) {
+        fprintf(stderr, "%s: FRESULT %d\n", what, (int)res);
+        exit(1);
+    }
+}
+
+static void result(const char *bench, const char *kase, uint32_t ops, uint64_t bytes, uint64_t ns)
+{
+    printf("bench=%s case=%s ops=%u ns=%llu ns_per_op=%.1f", bench, kase, (unsigned)ops,
+           (unsigned long long)ns, ops ? (double)ns / ops : 0.0);
+    if (bytes) printf(" bytes=%llu MBps=%.2f", (unsigned long long)bytes, ns ? bytes * 1000.0 / ns : 0.0);
+    printf("\n");
+}
+
+/* Create, format and mount an image of mb MiB */
+static void volume(const char *name, uint32_t mb)
+{
+    MKFS_PARM opt = { FM_FAT32, 2, 0, 0, 0 };
+
+    f_unmount("");
+    img_close();
+    snprintf(Path, sizeof Path, "%s/ffbench_%s.img", Dir, name);
+    if (img_create(Path, (uint64_t)mb << 20) != 0 || img_open(Path, IMG_MMAP) != 0) {
+        perror(Path);
+        exit(1);
+    }
+    check("f_mkfs", f_mkfs("", &opt, Work, sizeof Work));
+    check("f_mount", f_mount(&Vol, "", 1));
+}
+
+static void volume_done(void)
+{
+    f_unmount("");
+    img_close();
+    if (!Keep) unlink(Path);
+}
+
+static void bench_fat(void)
+{
+    FFOBJID obj = { 0 };
+    uint32_t n, i, c, sum = 0;
+    uint64_t t;
+
+    volume("fat", 256);
+    obj.fs = &Vol;
+    n = Vol.n_fatent - 3;
+    if (Quick && n > 16384) n = 16384;
+
+    t = now_ns();
+    for (c = 2; c < n + 2; c++) check("put_fat", put_fat(&Vol, c, c + 1));
+    check("sync_window", sync_window(&Vol));
+    result("put_fat", "seq", n, 0, now_ns() - t);
+
+    t = now_ns();
+    for (c = 2; c < n + 2; c++) sum += get_fat(&obj, c);
+    result("get_fat", "seq", n, 0, now_ns() - t);
+
+    t = now_ns();
+    for (i = 0; i < n; i++) sum += get_fat(&obj, 2 + rnd() % (Vol.n_fatent - 2));
+    result("get_fat", "random", n, 0, now_ns() - t);
+
+    t = now_ns();
+    for (i = 0; i < n; i++) check("put_fat", put_fat(&Vol, 2 + rnd() % (Vol.n_fatent - 2), 0));
+    check("sync_window", sync_window(&Vol));
+    result("put_fat", "random", n, 0, now_ns() - t);
+
+    if (sum == 1) printf("\n");     /* Keep the get_fat results alive */
+    volume_done();
+}
+
+static void bench_chain(void)
+{
+    static const char *const Case[] = { "empty", "half", "fragmented" };
+    FFOBJID obj = { 0 };
+    uint32_t k, n, i, c, clst;
+    uint64_t t;
+
+    for (k = 0; k < 3; k++) {
+        volume("chain", 256);
+        obj.fs = &Vol;
+        n = Vol.n_fatent - 2;
+
+        /* Half: the first half in use. Fragmented: 3 of 4 clusters in use at random */
+        for (c = 2; c < Vol.n_fatent; c++) {
+            if ((k == 1 && c < 2 + n / 2) || (k == 2 && rnd() % 4 != 0)) {
+                check("put_fat", put_fat(&Vol, c, 0x0FFFFFFF));
+            }
+        }
+        check("sync_window", sync_window(&Vol));
+        Vol.last_clst = 0;
+        Vol.free_clst = 0xFFFFFFFF;
+
+        n = Quick ? 2048 : 16384;
+        t = now_ns();
+        clst = 0;
+        for (i = 0; i < n; i++) {
+            clst = create_chain(&obj, clst);
+            if (clst < 2 || clst == 0xFFFFFFFF) check("create_chain", FR_INT_ERR);
+        }
+        check("sync_window", sync_window(&Vol));
+        result("create_chain", Case[k], n, 0, now_ns() - t);
+        volume_done();
+    }
+}
+
+static void bench_dir(void)
+{
+    static const uint32_t Size[] = { 10, 100, 1000, 10000 };
+    char name[32], dname[16], kase[32];
+    FILINFO fno;
+    FIL fil;
+    uint32_t k, n, i, reps;
+    uint64_t t;
+
+    volume("dir", 64);
+    for (k = 0; k < sizeof Size / sizeof Size[0]; k++) {
+        n = Size[k];
+        if (Quick && n > 1000) break;
+        snprintf(dname, sizeof dname, "D%u", (unsigned)n);
+        check("f_mkdir", f_mkdir(dname));
+
+        t = now_ns();
+        for (i = 0; i < n; i++) {
+            snprintf(name, sizeof name, "%s/F%07u.DAT", dname, (unsigned)i);
+            check("f_open", f_open(&fil, name, FA_CREATE_NEW | FA_WRITE));
+            check("f_close", f_close(&fil));
+        }
+        snprintf(kase, sizeof kase, "%u", (unsigned)n);
+        result("dir_create", kase, n, 0, now_ns() - t);
+
+        reps = (Quick ? 200000 : 2000000) / n;
+        if (reps < 20) reps = 20;
+        snprintf(name, sizeof name, "%s/F%07u.DAT", dname, (unsigned)(n - 1));
+        t = now_ns();
+        for (i = 0; i < reps; i++) check("f_stat", f_stat(name, &fno));
+        snprintf(kase, sizeof kase, "last_%u", (unsigned)n);
+        result("dir_find", kase, reps, 0, now_ns() - t);
+
+        t = now_ns();
+        for (i = 0; i < reps; i++) {
+            snprintf(name, sizeof name, "%s/F%07u.DAT", dname, (unsigned)(rnd() % n));
+            check("f_stat", f_stat(name, &fno));
+        }
+        snprintf(kase, sizeof kase, "random_%u", (unsigned)n);
+        result("dir_find", kase, reps, 0, now_ns() - t);
+
+        snprintf(name, sizeof name, "%s/MISSING.DAT", dname);
+        t = now_ns();
+        for (i = 0; i < reps; i++) {
+            if (f_stat(name, &fno) != FR_NO_FILE) check("f_stat", FR_INT_ERR);
+        }
+        snprintf(kase, sizeof kase, "miss_%u", (unsigned)n);
+        result("dir_find", kase, reps, 0, now_ns() - t);
+    }
+    volume_done();
+}
+
+static void bench_getfree(void)
+{
+    static const uint32_t Size[] = { 4096, 32768 };
+    FATFS *fs;
+    DWORD nclst;
+    uint32_t k;
+    uint64_t t;
+    char kase[16], name[32];
+
+    for (k = 0; k < 2; k++) {
+        if (Quick && k) break;
+        snprintf(kase, sizeof kase, "%uMB", (unsigned)Size[k]);
+        volume(kase, Size[k]);
+
+        t = now_ns();
+        check("f_getfree", f_getfree("", &nclst, &fs));
+        snprintf(name, sizeof name, "fsinfo_%s", kase);
+        result("f_getfree", name, 1, 0, now_ns() - t);
+
+        Vol.free_clst = 0xFFFFFFFF;     /* Force the FAT scan */
+        t = now_ns();
+        check("f_getfree", f_getfree("", &nclst, &fs));
+        snprintf(name, sizeof name, "scan_%s", kase);
+        result("f_getfree", name, 1, 0, now_ns() - t);
+        volume_done();
+    }
+}
+
+static void bench_rw(void)
+{
+    static const UINT Rec[] = { 1, 16, 128, 512, 4096, 32768, 65536 };
+    uint32_t fsize = Quick ? (1u << 20) : (8u << 20);
+    uint32_t k, i, ops;
+    uint64_t total, t;
+    char kase[32];
+    FIL fil;
+    UINT n, bw;
+
+    volume("rw", 64);
+    memset(Work, 0x5A, sizeof Work);
+    for (k = 0; k < sizeof Rec / sizeof Rec[0]; k++) {
+        total = (uint64_t)Rec[k] * (Quick ? 16384 : 262144);
+        if (total > fsize) total = fsize;
+        ops = (uint32_t)(total / Rec[k]);
+
+        check("f_open", f_open(&fil, "RW.BIN", FA_CREATE_ALWAYS | FA_WRITE | FA_READ));
+        t = now_ns();
+        for (i = 0; i < ops; i++) check("f_write", f_write(&fil, Work, Rec[k], &bw));
+        check("f_sync", f_sync(&fil));
+        snprintf(kase, sizeof kase, "seq_write_%u", (unsigned)Rec[k]);
+        result("rw", kase, ops, total, now_ns() - t);
+
+        while (f_size(&fil) < fsize) {  /* Extend to fsize for the random tests */
+            n = (fsize - (UINT)f_size(&fil) < sizeof Work) ? fsize - (UINT)f_size(&fil) : sizeof Work;
+            check("f_write", f_write(&fil, Work, n, &bw));
+        }
+
+        check("f_lseek", f_lseek(&fil, 0));
+        t = now_ns();
+        for (i = 0; i < ops; i++) check("f_read", f_read(&fil, Work, Rec[k], &bw));
+        snprintf(kase, sizeof kase, "seq_read_%u", (unsigned)Rec[k]);
+        result("rw", kase, ops, total, now_ns() - t);
+
+        t = now_ns();
+        for (i = 0; i < ops; i++) {
+            check("f_lseek", f_lseek(&fil, (FSIZE_t)(rnd() % (fsize / Rec[k])) * Rec[k]));
+            check("f_read", f_read(&fil, Work, Rec[k], &bw));
+        }
+        snprintf(kase, sizeof kase, "random_read_%u", (unsigned)Rec[k]);
+        result("rw", kase, ops, total, now_ns() - t);
+
+        t = now_ns();
+        for (i = 0; i < ops; i++) {
+            check("f_lseek", f_lseek(&fil, (FSIZE_t)(rnd() % (fsize / Rec[k])) * Rec[k]));
+            check("f_write", f_write(&fil, Work, Rec[k], &bw));
+        }
+        check("f_sync", f_sync(&fil));
+        snprintf(kase, sizeof kase, "random_write_%u", (unsigned)Rec[k]);
+        result("rw", kase, ops, total, now_ns() - t);
+
+        check("f_close", f_close(&fil));
+    }
+    volume_done();
+}
+
+static const struct {
+    const char *name;
+    void (*fn)(void);
+} Groups[] = {
+    { "fat", bench_fat },
+    { "chain", bench_chain },
+    { "dir", bench_dir },
+    { "getfree", bench_getfree },
+    { "rw", bench_rw },
+};
+
+int main(int argc, char **argv)
+{
+    size_t g;
+    int i, run;
+
+    for (argc--, argv++; argc && argv[0][0] == '-'; argc--, argv++) {
+        if (!strcmp(argv[0], "-q")) Quick = 1;
+        else if (!strcmp(argv[0], "-k")) Keep = 1;
+        else if (!strcmp(argv[0], "-d") && argc > 1) Dir = (argc--, *++argv);
+        else {
+            fprintf(stderr, "usage: ffbench [-q] [-k] [-d DIR] [fat|chain|dir|getfree|rw...]\n");
+            return 2;
+        }
+    }
+
+    printf("ffbench fs_tiny=%d use_lfn=%d max_ss=%d quick=%d\n", FF_FS_TINY, FF_USE_LFN, FF_MAX_SS, Quick);
+    for (g = 0; g < sizeof Groups / sizeof Groups[0]; g++) {
+        run = !argc;
+        for (i = 0; i < argc; i++) {
+            if (!strcmp(argv[i], Groups[g].name)) run = 1;
+        }
+        if (run) Groups[g].fn();
+    }
+    return 0;
+}
@@ -0,0 +1,176 @@
+/*********************************************************************************
+ * File Name          : ffhost.c
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : FatFs on a disk image from the host command line.
+ *********************************************************************************
+ * ffhost [-m] [-s] IMAGE COMMAND [ARG...]
+ *
+ *   -m            Access the image through mmap instead of pread/pwrite
+ *   -s            CTRL_SYNC flushes the image to the host disk
+ *
+ *   mkfs MB [AU]  Create an image of MB MiB and format it, with the data area
+ *                 aligned to AU sectors (default 1)
+ *   info          Show the volume geometry and free space
+ *   ls [DIR]      List a directory
+ *   put SRC DST   Copy a host file into the image
+ *   get SRC DST   Copy a file out of the image
+ *   mkdir DIR     Create a directory
+ *   rm PATH       Remove a file or an empty directory
+ *******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ff.h"
+#include "perf.h"
+#include "diskio_img.h"
+
+static FATFS Fs;
+static BYTE Buf[32768];
+
+static int fail(const char *what, FRESULT res)
+{
+    fprintf(stderr, "%s: FRESULT %d\n", what, (int)res);
+    return 1;
+}
+
+static int cmd_mkfs(const char *img, int flags, int argc, char **argv)
+{
+    MKFS_PARM opt = { FM_FAT32, 2, 0, 0, 0 };
+    FRESULT res;
+
+    if (argc < 1) return fail("mkfs: size", FR_INVALID_PARAMETER);
+    if (img_create(img, (uint64_t)strtoul(argv[0], 0, 0) << 20) != 0) {
+        perror(img);
+        return 1;
+    }
+    if (img_open(img, flags) != 0) {
+        perror(img);
+        return 1;
+    }
+    img_set_block(argc > 1 ? (uint32_t)strtoul(argv[1], 0, 0) : 1);
+    res = f_mkfs("", &opt, Buf, sizeof Buf);
+    return res ? fail("f_mkfs", res) : 0;
+}
+
+static int cmd_info(void)
+{
+    FATFS *fs;
+    DWORD nclst;
+    FRESULT res = f_getfree("", &nclst, &fs);
+
+    if (res) return fail("f_getfree", res);
+    printf("type      FAT%s\n", fs->fs_type == FS_FAT12 ? "12" : fs->fs_type == FS_FAT16 ? "16" : "32");
+    printf("cluster   %u sectors\n", (unsigned)fs->csize);
+    printf("clusters  %u (%u free)\n", (unsigned)(fs->n_fatent - 2), (unsigned)nclst);
+    printf("fatbase   %u\n", (unsigned)fs->fatbase);
+    printf("fsize     %u x %u\n", (unsigned)fs->fsize, (unsigned)fs->n_fats);
+    printf("database  %u\n", (unsigned)fs->database);
+    return 0;
+}
+
+static int cmd_ls(const char *path)
+{
+    DIR dir;
+    FILINFO fno;
+    FRESULT res = f_opendir(&dir, path);
+
+    if (res) return fail("f_opendir", res);
+    while ((res = f_readdir(&dir, &fno)) == FR_OK && fno.fname[0]) {
+        printf("%10lu %c %s\n", (unsigned long)fno.fsize, (fno.fattrib & AM_DIR) ? 'd' : '-', fno.fname);
+    }
+    f_closedir(&dir);
+    return res ? fail("f_readdir", res) : 0;
+}
+
+static int cmd_put(const char *src, const char *dst)
+{
+    FILE *in = fopen(src, "rb");
+    FIL fil;
+    size_t n;
+    UINT bw;
+    FRESULT res;
+
+    if (!in) {
+        perror(src);
+        return 1;
+    }
+    res = f_open(&fil, dst, FA_CREATE_ALWAYS | FA_WRITE);
+    while (res == FR_OK && (n = fread(Buf, 1, sizeof Buf, in)) > 0) {
+        res = f_write(&fil, Buf, (UINT)n, &bw);
+        if (res == FR_OK && bw != n) res = FR_DENIED;
+    }
+    fclose(in);
+    if (res) return fail("put", res);
+    res = f_close(&fil);
+    return res ? fail("f_close", res) : 0;
+}
+
+static int cmd_get(const char *src, const char *dst)
+{
+    FILE *out;
+    FIL fil;
+    UINT br;
+    FRESULT res = f_open(&fil, src, FA_READ);
+
+    if (res) return fail("f_open", res);
+    out = fopen(dst, "wb");
+    if (!out) {
+        perror(dst);
+        return 1;
+    }
+    while ((res = f_read(&fil, Buf, sizeof Buf, &br)) == FR_OK && br) {
+        fwrite(Buf, 1, br, out);
+    }
+    fclose(out);
+    f_close(&fil);
+    return res ? fail("f_read", res) : 0;
+}
+
+int main(int argc, char **argv)
+{
+    int flags = IMG_PREAD, rc;
+    const char *img, *cmd;
+    FRESULT res;
+
+    for (argc--, argv++; argc && argv[0][0] == '-'; argc--, argv++) {
+        if (!strcmp(argv[0], "-m")) flags |= IMG_MMAP;
+        else if (!strcmp(argv[0], "-s")) flags |= IMG_FSYNC;
+        else break;
+    }
+    if (argc < 2) {
+        fprintf(stderr, "usage: ffhost [-m] [-s] IMAGE mkfs|info|ls|put|get|mkdir|rm [ARG...]\n");
+        return 2;
+    }
+    img = argv[0];
+    cmd = argv[1];
+    argc -= 2;
+    argv += 2;
+
+    if (!strcmp(cmd, "mkfs")) {
+        rc = cmd_mkfs(img, flags, argc, argv);
+        img_close();
+        return rc;
+    }
+
+    if (img_open(img, flags) != 0) {
+        perror(img);
+        return 1;
+    }
+    res = f_mount(&Fs, "", 1);
+    if (res) return fail("f_mount", res);
+
+    if (!strcmp(cmd, "info")) rc = cmd_info();
+    else if (!strcmp(cmd, "ls")) rc = cmd_ls(argc ? argv[0] : "");
+    else if (!strcmp(cmd, "put") && argc >= 2) rc = cmd_put(argv[0], argv[1]);
+    else if (!strcmp(cmd, "get") && argc >= 2) rc = cmd_get(argv[0], argv[1]);
+    else if (!strcmp(cmd, "mkdir") && argc >= 1) rc = (res = f_mkdir(argv[0])) ? fail("f_mkdir", res) : 0;
+    else if (!strcmp(cmd, "rm") && argc >= 1) rc = (res = f_unlink(argv[0])) ? fail("f_unlink", res) : 0;
+    else rc = fail(cmd, FR_INVALID_PARAMETER);
+
+    f_unmount("");
+    PERF_Dump();
+    img_close();
+    return rc;
+}
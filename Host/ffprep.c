@@ -0,0 +1,263 @@
+/*********************************************************************************
+ * File Name          : ffprep.c
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Card image preparation with contiguous, AU-aligned files.
+ *********************************************************************************
+ * ffprep [-s] [-c BYTES] IMAGE MB AU LAYOUT
+ *
+ *   -s            Flush the image to the host disk on CTRL_SYNC
+ *   -c BYTES      Cluster size (default: chosen by f_mkfs)
+ *
+ * Creates an image of MB MiB, formats it with the data area aligned to AU
+ * sectors (the card allocation unit, see ACMD13 or DSTAT) and builds the
+ * layout described in the LAYOUT file, one entry per line:
+ *
+ *   # comment
+ *   DIR/          a directory (parents are created as needed)
+ *   PATH SIZE     a file of SIZE bytes, with a K, M or G suffix allowed
+ *
+ * Directories are created first so their clusters sit together at the start
+ * of the data area. Each file is then allocated with f_expand as a single
+ * contiguous chain starting on an AU boundary, in layout order. The files are
+ * full size from the start: the device opens them with FA_WRITE, moves with
+ * f_lseek and overwrites in place, so FatFs never walks a fragmented chain,
+ * never allocates a cluster and never touches the FAT at runtime; only the
+ * data sectors and the directory entry (on f_sync) are written.
+ *
+ * The firmware mounts FAT32 only (FF_FS_FATTYPES 4), which needs at least
+ * 65526 clusters: 33 MiB with the default cluster size, 257 MiB with -c 4096.
+ * When the image is too small for -c, ffprep says how large it must be.
+ *
+ * The data of the files is left as it is in the image, zero for a new one.
+ * The image can be written to the card with dd at offset 0.
+ *******************************************************************************/
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ff.h"
+#include "perf.h"
+#include "diskio_img.h"
+
+#define LINE_MAX_LEN    256
+#define FAT32_MIN_CLST  65526           /* MAX_FAT16 + 1 in ff.c */
+#define MBR_OFS         63              /* Partition start of f_mkfs, N_SEC_TRACK in ff.c */
+
+static FATFS Fs;
+static BYTE Buf[32768];
+static uint32_t Au;
+
+static int fail(const char *what, FRESULT res)
+{
+    fprintf(stderr, "%s: FRESULT %d\n", what, (int)res);
+    return 1;
+}
+
+static LBA_t clst2sect(DWORD clst)
+{
+    return Fs.database + (LBA_t)Fs.csize * (clst - 2);
+}
+
+/* First cluster from clst on whose first sector is on an AU boundary */
+static DWORD next_aligned(DWORD clst)
+{
+    DWORD n;
+
+    if (clst < 2) clst = 2;
+    for (n = 0; n < Au; n++, clst++) {
+        if (clst >= Fs.n_fatent) break;
+        if (clst2sect(clst) % Au == 0) return clst;
+    }
+    return 0;       /* Data area not aligned or end of volume */
+}
+
+/* Create every directory on the path, up to the last '/' */
+static FRESULT mkdirs(const char *path)
+{
+    char dir[LINE_MAX_LEN];
+    const char *p;
+    FRESULT res;
+
+    for (p = strchr(path, '/'); p; p = strchr(p + 1, '/')) {
+        if (p == path) continue;
+        memcpy(dir, path, (size_t)(p - path));
+        dir[p - path] = 0;
+        res = f_mkdir(dir);
+        if (res != FR_OK && res != FR_EXIST) return res;
+    }
+    return FR_OK;
+}
+
+/*
+ * Smallest image in MiB that f_mkfs formats as FAT32 with clusters of au
+ * sectors, following its layout: MBR, 32 reserved sectors, 2 FATs, data
+ * area aligned to Au. FF_FS_FATTYPES 4 mounts nothing else.
+ */
+static unsigned long fat32_min_mb(DWORD au)
+{
+    DWORD blk = (Au <= 0x8000 && !(Au & (Au - 1))) ? Au : 1;
+    DWORD vol, fat, data, rsv;
+    unsigned long mb;
+
+    for (mb = 1; mb < 0x200000; mb++) {     /* FAT32 limit of 2^32 sectors */
+        vol = (DWORD)(mb << 11) - MBR_OFS;
+        if (vol / au < FAT32_MIN_CLST) continue;
+        fat = ((vol / au) * 4 + 8 + 511) / 512;
+        data = MBR_OFS + 32 + 2 * fat;
+        rsv = 32 + (((data + blk - 1) & ~(blk - 1)) - data);
+        if ((vol - rsv - 2 * fat) / au >= FAT32_MIN_CLST) return mb;
+    }
+    return 0;
+}
+
+static int parse_size(const char *s, FSIZE_t *size)
+{
+    char *end;
+    unsigned long long v = strtoull(s, &end, 0);
+
+    switch (toupper((unsigned char)*end)) {
+    case 'G': v <<= 10;     /* Fall through */
+    case 'M': v <<= 10;     /* Fall through */
+    case 'K': v <<= 10; end++; break;
+    }
+    if (end == s || *end || v == 0 || v > 0xFFFFFFFFULL) return -1;
+    *size = (FSIZE_t)v;
+    return 0;
+}
+
+/*
+ * Allocate a contiguous chain for an empty file, starting on the first AU
+ * boundary from which f_expand finds enough free clusters.
+ */
+static FRESULT expand_aligned(FIL *fp, FSIZE_t size)
+{
+    DWORD clst = next_aligned(Fs.last_clst + 1), scl;
+    FRESULT res;
+
+    while (clst) {
+        Fs.last_clst = clst;
+        res = f_expand(fp, size, 0);        /* Find only, last_clst = found - 1 */
+        if (res != FR_OK) return res;
+        scl = Fs.last_clst + 1;
+        if (scl == clst) {
+            Fs.last_clst = clst;
+            return f_expand(fp, size, 1);
+        }
+        if (scl < clst) return FR_DENIED;   /* Wrapped around */
+        clst = next_aligned(scl);
+    }
+    return FR_DENIED;
+}
+
+static int make_file(const char *path, FSIZE_t size)
+{
+    FIL fil;
+    DWORD sclst;
+    FRESULT res;
+
+    res = mkdirs(path);
+    if (res) return fail(path, res);
+    res = f_open(&fil, path, FA_CREATE_ALWAYS | FA_WRITE);
+    if (res) return fail(path, res);
+    res = expand_aligned(&fil, size);
+    sclst = fil.obj.sclust;
+    if (res == FR_OK) res = f_close(&fil); else f_close(&fil);
+    if (res) return fail(path, res);
+
+    printf("file %s size=%lu cluster=%lu sector=%lu clusters=%lu%s\n", path,
+           (unsigned long)size, (unsigned long)sclst, (unsigned long)clst2sect(sclst),
+           (unsigned long)(((unsigned long long)size + Fs.csize * 512 - 1) / (Fs.csize * 512)),
+           clst2sect(sclst) % Au ? " UNALIGNED" : "");
+    return 0;
+}
+
+/* Runs the directory entries (files == 0) or the file entries of the layout */
+static int layout(FILE *in, int files)
+{
+    char line[LINE_MAX_LEN], path[LINE_MAX_LEN], size[64];
+    FSIZE_t sz;
+    FRESULT res;
+    int n, lineno = 0;
+    size_t len;
+
+    rewind(in);
+    while (fgets(line, sizeof line, in)) {
+        lineno++;
+        n = sscanf(line, "%255s %63s", path, size);
+        if (n < 1 || path[0] == '#') continue;
+        len = strlen(path);
+        if (n == 1 && path[len - 1] == '/') {
+            if (files) continue;
+            res = mkdirs(path);
+            if (res) return fail(path, res);
+            printf("dir  %s\n", path);
+        } else if (n == 2 && parse_size(size, &sz) == 0) {
+            if (!files) continue;
+            if (make_file(path, sz)) return 1;
+        } else {
+            fprintf(stderr, "layout:%d: expected 'DIR/' or 'PATH SIZE'\n", lineno);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    MKFS_PARM opt = { FM_FAT32, 2, 0, 0, 0 };
+    int flags = IMG_PREAD, rc;
+    DWORD nclst, au;
+    FATFS *fs;
+    FILE *in;
+    FRESULT res;
+
+    for (argc--, argv++; argc && argv[0][0] == '-'; argc--, argv++) {
+        if (!strcmp(argv[0], "-s")) flags |= IMG_FSYNC;
+        else if (!strcmp(argv[0], "-c") && argc > 1) opt.au_size = (DWORD)strtoul((++argv)[0], 0, 0), argc--;
+        else break;
+    }
+    if (argc != 4) {
+        fprintf(stderr, "usage: ffprep [-s] [-c BYTES] IMAGE MB AU LAYOUT\n");
+        return 2;
+    }
+    Au = (uint32_t)strtoul(argv[2], 0, 0);
+    if (Au == 0) Au = 1;
+    in = fopen(argv[3], "r");
+    if (!in) {
+        perror(argv[3]);
+        return 1;
+    }
+
+    if (img_create(argv[0], (uint64_t)strtoul(argv[1], 0, 0) << 20) != 0 || img_open(argv[0], flags) != 0) {
+        perror(argv[0]);
+        return 1;
+    }
+    img_set_block(Au);
+    res = f_mkfs("", &opt, Buf, sizeof Buf);
+    if (res == FR_MKFS_ABORTED) {
+        au = (opt.au_size >= 512 && !(opt.au_size & (opt.au_size - 1))) ? opt.au_size / 512 : 1;
+        if (au > 128) au = 128;
+        fprintf(stderr, "format: FAT32 needs at least %u clusters, with %lu-byte clusters the image must be %lu MiB or more\n",
+                FAT32_MIN_CLST, (unsigned long)au * 512, fat32_min_mb(au));
+        img_close();
+        return 1;
+    }
+    if (res == FR_OK) res = f_mount(&Fs, "", 1);
+    if (res) return fail("format", res);
+    printf("volume cluster=%u database=%lu au=%lu%s\n", (unsigned)Fs.csize, (unsigned long)Fs.database,
+           (unsigned long)Au, Fs.database % Au ? " UNALIGNED" : "");
+
+    rc = layout(in, 0);
+    if (rc == 0) rc = layout(in, 1);
+    fclose(in);
+
+    if (rc == 0 && (res = f_getfree("", &nclst, &fs)) != FR_OK) rc = fail("f_getfree", res);
+    if (rc == 0) printf("free %lu clusters\n", (unsigned long)nclst);
+    res = f_unmount("");
+    if (rc == 0 && res) rc = fail("f_unmount", res);
+    PERF_Dump();
+    img_close();
+    return rc;
+}
@@ -0,0 +1,42 @@
+#!/usr/bin/env python3
+"""Make the SD card update file for User/fwup.c from a firmware binary.
+
+Usage: fwpack.py [--max BYTES] firmware.bin [FIRMWARE.UPD]
+
+The binary (objcopy -O binary of the ELF) is padded with 0xFF to a whole
+number of 64-byte flash pages and followed by its CRC-32 and the "FWUP"
+magic, both little-endian. Copy the output to the root of the card under
+FWUP_FILE; it must be contiguous on the card, which it is when copied to a
+freshly formatted card or one with enough free space at the end.
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+PAGE = 64
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    ap.add_argument('--max', type=int, default=16 * 1024 - 1024,
+                    help='application region size, 16K - __kv_size (default %(default)s)')
+    ap.add_argument('bin')
+    ap.add_argument('out', nargs='?', default='FIRMWARE.UPD')
+    args = ap.parse_args()
+
+    with open(args.bin, 'rb') as f:
+        image = f.read()
+    image += b'\xff' * (-len(image) % PAGE)
+    if not image or len(image) > args.max:
+        sys.exit('%s: %d bytes, the application region is %d' % (args.bin, len(image), args.max))
+
+    with open(args.out, 'wb') as f:
+        f.write(image)
+        f.write(struct.pack('<I4s', zlib.crc32(image), b'FWUP'))
+    print('%s: %d bytes, %d pages, crc32 %08x' % (args.out, len(image), len(image) // PAGE, zlib.crc32(image)))
+
+
+if __name__ == '__main__':
+    main()
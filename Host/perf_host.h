@@ -0,0 +1,24 @@
+/*********************************************************************************
+ * File Name          : perf_host.h
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : PERF_NOW for the host build (forced in by the Makefile).
+ *******************************************************************************/
+#ifndef __PERF_HOST_H
+#define __PERF_HOST_H
+
+#include <stdint.h>
+#include <time.h>
+
+static inline uint32_t perf_host_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+
+#define PERF_NOW()      perf_host_now()
+#define PERF_UNIT       "ns"
+
+#endif /* __PERF_HOST_H */
@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+"""Map a PROF_Dump histogram back to the symbols of the firmware ELF.
+
+Usage: prof.py [-n NM] [-b] firmware.elf [console.log]
+
+The console log is read from stdin when it is not given. Only the last
+"PROF base:" ... "PROF end" block in it is used. A bucket that covers
+several functions is split between them by the number of bytes each one
+has in the bucket, so the per-symbol counts are estimates at the bucket
+resolution.
+
+Flash buckets are matched against the code symbols outside .ramfunc and
+.fwup, the RAM buckets (from the "ram:" field of the header) against the
+.ramfunc symbols at their run addresses. .fwup overlays the start of RAM
+only once the updater runs, so its symbols never take RAM samples.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+RAMFUNC_MAX = 512    # __ramfunc_max in Ld/Link.ld, PROF_RAM_SIZE in User/prof.h
+
+
+def read_dump(f):
+    base = shift = other = None
+    ram = rshift = None
+    hist = {}
+    for line in f:
+        line = line.strip()
+        m = re.match(r'PROF base:([0-9a-fA-F]+) shift:(\d+) other:(\d+)'
+                     r'(?: ram:([0-9a-fA-F]+) rshift:(\d+))?', line)
+        if m:
+            base, shift, other = int(m.group(1), 16), int(m.group(2)), int(m.group(3))
+            if m.group(4):
+                ram, rshift = int(m.group(4), 16), int(m.group(5))
+            hist = {}
+            continue
+        m = re.match(r'PROF ([0-9a-fA-F]{8}) (\d+)', line)
+        if m and shift is not None:
+            hist[int(m.group(1), 16)] = int(m.group(2))
+    if shift is None:
+        sys.exit('no PROF dump found')
+    return base, shift, other, ram, rshift, hist
+
+
+def read_symbols(nm, elf):
+    """Return (flash, ramfunc) lists of (address, size, name) code symbols."""
+    out = subprocess.run([nm, '-f', 'sysv', '-S', '--defined-only', elf],
+                         check=True, capture_output=True, text=True).stdout
+    flash, ramfunc = [], []
+    for line in out.splitlines():
+        f = [x.strip() for x in line.split('|')]
+        if len(f) < 7 or f[2] not in 'tTwW' or not f[4]:
+            continue
+        sym = (int(f[1], 16), int(f[4], 16), f[0])
+        if f[6] == '.ramfunc':
+            ramfunc.append(sym)
+        elif f[6] != '.fwup':
+            flash.append(sym)
+    return flash, ramfunc
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument('-n', '--nm', default=os.environ.get('NM', 'riscv-none-embed-nm'),
+                    help='nm of the cross toolchain (default $NM or riscv-none-embed-nm)')
+    ap.add_argument('-b', '--buckets', action='store_true', help='also list the buckets')
+    ap.add_argument('elf')
+    ap.add_argument('log', nargs='?', type=argparse.FileType('r', errors='replace'), default=sys.stdin)
+    args = ap.parse_args()
+
+    base, shift, other, ram, rshift, hist = read_dump(args.log)
+    flash, ramfunc = read_symbols(args.nm, args.elf)
+    total = sum(hist.values()) + other
+
+    per_sym = {}
+    for addr, count in sorted(hist.items()):
+        if ram is not None and ram <= addr < ram + RAMFUNC_MAX:
+            syms, size = ramfunc, 1 << rshift
+        else:
+            syms, size = flash, 1 << shift
+        names = []
+        for start, length, name in syms:
+            ovl = min(addr + size, start + length) - max(addr, start)
+            if ovl > 0:
+                names.append((name, ovl))
+        covered = sum(n for _, n in names)
+        if not covered:
+            names, covered = [('?', 1)], 1
+        for name, ovl in names:
+            per_sym[name] = per_sym.get(name, 0) + count * ovl / covered
+        if args.buckets:
+            print('%08x %6d  %s' % (addr, count, ' '.join(n for n, _ in names)))
+    if other:
+        per_sym['(outside flash and .ramfunc)'] = other
+    if args.buckets:
+        print()
+
+    if ram is None:
+        print('%d samples, %d-byte buckets' % (total, 1 << shift))
+    else:
+        print('%d samples, %d-byte flash and %d-byte .ramfunc buckets' % (total, 1 << shift, 1 << rshift))
+    for name, count in sorted(per_sym.items(), key=lambda x: -x[1]):
+        print('%8.1f %5.1f%%  %s' % (count, 100.0 * count / total if total else 0, name))
+
+
+if __name__ == '__main__':
+    main()
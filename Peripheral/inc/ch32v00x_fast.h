@@ -0,0 +1,140 @@
+/*********************************************************************************
+ * File Name          : ch32v00x_fast.h
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Inline register access for the GPIO, SPI, USART and
+ *                      DMA hot paths.
+ *********************************************************************************
+ * Each function does what the library function of the same name without
+ * _Fast does, for the same arguments, but is always inlined and has no
+ * parameter check. With a constant port, pin, instance or flag, as in
+ *
+ *   GPIO_WriteBit_Fast(GPIOC, GPIO_Pin_3, Bit_SET);
+ *
+ * the call folds to one store (sw to GPIOC->BSHR) where GPIO_WriteBit is a
+ * jal, a branch, the store and a ret; a flag test folds to a load and an
+ * andi. They need no flash, so they are also safe in RAMFUNC code that runs
+ * while the flash is erased. SDBENCH_API measures the difference on the
+ * target.
+ *
+ * Use them where the cost of the call shows: byte loops, polling loops and
+ * interrupt handlers. Initialisation stays with the library functions.
+ *******************************************************************************/
+#ifndef __CH32V00x_FAST_H
+#define __CH32V00x_FAST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <ch32v00x.h>
+#include <ch32v00x_gpio.h>
+#include <ch32v00x_spi.h>
+#include <ch32v00x_usart.h>
+#include <ch32v00x_dma.h>
+
+#define FAST_INLINE     __attribute__( ( always_inline ) ) RV_STATIC_INLINE
+
+/* GPIO */
+FAST_INLINE void GPIO_SetBits_Fast(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    GPIOx->BSHR = GPIO_Pin;
+}
+
+FAST_INLINE void GPIO_ResetBits_Fast(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    GPIOx->BCR = GPIO_Pin;
+}
+
+/* Set and reset in one store: BSHR high half resets */
+FAST_INLINE void GPIO_WriteBit_Fast(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, BitAction BitVal)
+{
+    GPIOx->BSHR = (BitVal != Bit_RESET) ? (uint32_t)GPIO_Pin : (uint32_t)GPIO_Pin << 16;
+}
+
+FAST_INLINE uint8_t GPIO_ReadInputDataBit_Fast(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    return (GPIOx->INDR & GPIO_Pin) ? (uint8_t)Bit_SET : (uint8_t)Bit_RESET;
+}
+
+/* SPI */
+FAST_INLINE FlagStatus SPI_I2S_GetFlagStatus_Fast(SPI_TypeDef *SPIx, uint16_t SPI_I2S_FLAG)
+{
+    return (SPIx->STATR & SPI_I2S_FLAG) ? SET : RESET;
+}
+
+FAST_INLINE void SPI_I2S_SendData_Fast(SPI_TypeDef *SPIx, uint16_t Data)
+{
+    SPIx->DATAR = Data;
+}
+
+FAST_INLINE uint16_t SPI_I2S_ReceiveData_Fast(SPI_TypeDef *SPIx)
+{
+    return (uint16_t)SPIx->DATAR;
+}
+
+/* One full-duplex byte with the bus idle before and after, as xchg_spi in diskio.c */
+FAST_INLINE uint8_t SPI_Xchg_Fast(SPI_TypeDef *SPIx, uint8_t Data)
+{
+    uint8_t ret;
+
+    while(SPIx->STATR & SPI_I2S_FLAG_BSY);
+    SPIx->DATAR = Data;
+    while(!(SPIx->STATR & SPI_I2S_FLAG_TXE));
+    __asm volatile("nop");
+    while(!(SPIx->STATR & SPI_I2S_FLAG_RXNE));
+    ret = (uint8_t)SPIx->DATAR;
+    while(SPIx->STATR & SPI_I2S_FLAG_BSY);
+    return ret;
+}
+
+/* USART */
+FAST_INLINE FlagStatus USART_GetFlagStatus_Fast(USART_TypeDef *USARTx, uint16_t USART_FLAG)
+{
+    return (USARTx->STATR & USART_FLAG) ? SET : RESET;
+}
+
+FAST_INLINE void USART_SendData_Fast(USART_TypeDef *USARTx, uint16_t Data)
+{
+    USARTx->DATAR = Data & (uint16_t)0x01FF;
+}
+
+FAST_INLINE uint16_t USART_ReceiveData_Fast(USART_TypeDef *USARTx)
+{
+    return (uint16_t)(USARTx->DATAR & (uint16_t)0x01FF);
+}
+
+/* DMA */
+FAST_INLINE void DMA_Cmd_Fast(DMA_Channel_TypeDef *DMAy_Channelx, FunctionalState NewState)
+{
+    if(NewState != DISABLE)
+        DMAy_Channelx->CFGR |= DMA_CFGR1_EN;
+    else
+        DMAy_Channelx->CFGR &= (uint16_t)~DMA_CFGR1_EN;
+}
+
+FAST_INLINE void DMA_SetCurrDataCounter_Fast(DMA_Channel_TypeDef *DMAy_Channelx, uint16_t DataNumber)
+{
+    DMAy_Channelx->CNTR = DataNumber;
+}
+
+FAST_INLINE uint16_t DMA_GetCurrDataCounter_Fast(DMA_Channel_TypeDef *DMAy_Channelx)
+{
+    return (uint16_t)DMAy_Channelx->CNTR;
+}
+
+FAST_INLINE ITStatus DMA_GetITStatus_Fast(uint32_t DMAy_IT)
+{
+    return (DMA1->INTFR & DMAy_IT) ? SET : RESET;
+}
+
+FAST_INLINE void DMA_ClearITPendingBit_Fast(uint32_t DMAy_IT)
+{
+    DMA1->INTFCR = DMAy_IT;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CH32V00x_FAST_H */
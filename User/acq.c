@@ -0,0 +1,312 @@
+/*********************************************************************************
+ * File Name          : acq.c
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Timer triggered ADC acquisition to SD card.
+ *******************************************************************************/
+#include "acq.h"
+#include "clkgov.h"
+#include "sched.h"
+
+#if ACQ_ENABLE
+
+#if !FF_FS_TINY
+#error ADC acquisition needs FF_FS_TINY = 1 to fit the DMA ring in RAM
+#endif
+
+void DMA1_Channel1_IRQHandler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
+
+volatile ACQ_StatTypeDef ACQ_Stat;
+
+static uint16_t Ring[ACQ_BLOCK_SIZE];   /* Two halves of ACQ_BLOCK_SIZE bytes */
+static volatile uint8_t Full[2];        /* Half is filled and not yet written */
+static uint8_t Next;                    /* Half to be written next */
+
+static const uint8_t Channels[ACQ_CHANNELS] = { ACQ_CHANNEL_LIST };
+
+/* Pins of the analog inputs A0..A7 */
+static GPIO_TypeDef * const PinPort[8] = { GPIOA, GPIOA, GPIOC, GPIOD, GPIOD, GPIOD, GPIOD, GPIOD };
+static const uint8_t PinNum[8] = { 2, 1, 4, 2, 3, 5, 6, 4 };
+
+#if ACQ_OSR_LOG2
+#define RAW_WORDS   (ACQ_RAW_SCANS * ACQ_CHANNELS)     /* Per half */
+#define DMA_BUF     Raw
+static uint16_t Raw[2 * RAW_WORDS];     /* Scans stored by DMA */
+static uint16_t Out;                    /* Ring index of the next result */
+#if SCHED_ENABLE
+static sched_task_t ReduceTask;
+static volatile uint8_t RawFull[2];     /* Raw half is filled and not yet reduced */
+static uint8_t RawNext;                 /* Raw half to be reduced next */
+static uint8_t reduce_task(sched_task_t *t);
+#endif
+#else
+#define DMA_BUF     Ring
+#endif
+
+/* TIM2 update at ACQ_RATE_HZ from the current clock */
+static void acq_timer(void)
+{
+    uint32_t div = SystemCoreClock / ACQ_RATE_HZ;  /* Timer clocks per sample */
+    uint16_t psc = div >> 16;                       /* Keep the period in 16 bits */
+
+    TIM2->PSC = psc;
+    TIM2->ATRLR = div / (psc + 1) - 1;
+}
+
+#if CLKGOV_ENABLE
+static void acq_clock(uint32_t old_hz, uint32_t new_hz)
+{
+    acq_timer();
+}
+#endif
+
+/*********************************************************************
+ * @fn      ACQ_Init
+ *
+ * @brief   Initializes the analog input, TIM2, ADC1 and DMA1 channel 1.
+ *        The acquisition does not run until ACQ_Start is called.
+ *
+ * @return  none
+ */
+void ACQ_Init(void)
+{
+    GPIO_InitTypeDef GPIO_InitStructure = {0};
+    ADC_InitTypeDef ADC_InitStructure = {0};
+    DMA_InitTypeDef DMA_InitStructure = {0};
+    TIM_TimeBaseInitTypeDef TIM_TimeBaseInitStructure = {0};
+    NVIC_InitTypeDef NVIC_InitStructure = {0};
+
+    uint8_t i;
+
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOA | RCC_APB2Periph_GPIOC | RCC_APB2Periph_GPIOD |
+                           RCC_APB2Periph_ADC1, ENABLE);
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM2, ENABLE);
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AIN;
+    for (i = 0; i < ACQ_CHANNELS; i++) {
+        if (Channels[i] > ADC_Channel_7) continue;      /* Vrefint, Vcalint */
+        GPIO_InitStructure.GPIO_Pin = 1 << PinNum[Channels[i]];
+        GPIO_Init(PinPort[Channels[i]], &GPIO_InitStructure);
+    }
+
+    /* TIM2 update event is the conversion trigger */
+    TIM_TimeBaseInitStructure.TIM_ClockDivision = TIM_CKD_DIV1;
+    TIM_TimeBaseInitStructure.TIM_CounterMode = TIM_CounterMode_Up;
+    TIM_TimeBaseInit(TIM2, &TIM_TimeBaseInitStructure);
+    acq_timer();
+    TIM_PrescalerConfig(TIM2, TIM2->PSC, TIM_PSCReloadMode_Immediate);
+    TIM_SelectOutputTrigger(TIM2, TIM_TRGOSource_Update);
+    CLKGOV_Register(acq_clock);         /* Keep the sample rate on clock switches */
+
+    /* ADC1: regular scan of the channels started by TIM2 TRGO, results moved by DMA */
+    RCC_ADCCLKConfig(RCC_PCLK2_Div4);
+    ADC_DeInit(ADC1);
+    ADC_InitStructure.ADC_Mode = ADC_Mode_Independent;
+    ADC_InitStructure.ADC_ScanConvMode = (ACQ_CHANNELS > 1) ? ENABLE : DISABLE;
+    ADC_InitStructure.ADC_ContinuousConvMode = DISABLE;
+    ADC_InitStructure.ADC_ExternalTrigConv = ADC_ExternalTrigConv_T2_TRGO;
+    ADC_InitStructure.ADC_DataAlign = ADC_DataAlign_Right;
+    ADC_InitStructure.ADC_NbrOfChannel = ACQ_CHANNELS;
+    ADC_Init(ADC1, &ADC_InitStructure);
+    for (i = 0; i < ACQ_CHANNELS; i++) {
+        ADC_RegularChannelConfig(ADC1, Channels[i], i + 1, ACQ_SAMPLE_TIME);
+    }
+    ADC_DMACmd(ADC1, ENABLE);
+    ADC_Cmd(ADC1, ENABLE);
+
+    ADC_ResetCalibration(ADC1);
+    while(ADC_GetResetCalibrationStatus(ADC1));
+    ADC_StartCalibration(ADC1);
+    while(ADC_GetCalibrationStatus(ADC1));
+
+    ADC_ExternalTrigConvCmd(ADC1, ENABLE);
+
+    /* DMA1 channel 1: circular over both halves, interrupt at each half */
+    DMA_DeInit(DMA1_Channel1);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&ADC1->RDATAR;
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)DMA_BUF;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_BufferSize = sizeof(DMA_BUF) / sizeof(DMA_BUF[0]);
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_VeryHigh;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init(DMA1_Channel1, &DMA_InitStructure);
+    DMA_ITConfig(DMA1_Channel1, DMA_IT_HT | DMA_IT_TC, ENABLE);
+
+    NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel1_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
+
+#if ACQ_OSR_LOG2 && SCHED_ENABLE
+    sched_add(&ReduceTask, reduce_task, SCHED_NESTABLE);
+#endif
+}
+
+/*********************************************************************
+ * @fn      ACQ_Start
+ *
+ * @brief   Starts sampling from the top of the ring.
+ *
+ * @return  none
+ */
+void ACQ_Start(void)
+{
+    Full[0] = Full[1] = 0;
+    Next = 0;
+#if ACQ_OSR_LOG2
+    Out = 0;
+#if SCHED_ENABLE
+    RawFull[0] = RawFull[1] = 0;
+    RawNext = 0;
+#endif
+#endif
+
+    DMA_Cmd(DMA1_Channel1, DISABLE);
+    DMA_SetCurrDataCounter(DMA1_Channel1, sizeof(DMA_BUF) / sizeof(DMA_BUF[0]));
+    DMA_Cmd(DMA1_Channel1, ENABLE);
+
+    TIM_SetCounter(TIM2, 0);
+    TIM_Cmd(TIM2, ENABLE);
+}
+
+/*********************************************************************
+ * @fn      ACQ_Stop
+ *
+ * @brief   Stops sampling. The samples in a partly filled half are
+ *        discarded, filled halves are still written by ACQ_Poll.
+ *
+ * @return  none
+ */
+void ACQ_Stop(void)
+{
+    TIM_Cmd(TIM2, DISABLE);
+    DMA_Cmd(DMA1_Channel1, DISABLE);
+}
+
+/*********************************************************************
+ * @fn      ACQ_Poll
+ *
+ * @brief   Writes the filled halves to the file, one block each. The
+ *        file is synced every ACQ_SYNC_BLOCKS blocks. The card is
+ *        written at CLKGOV_BUSY and the clock is left at CLKGOV_IDLE.
+ *
+ * @param   fp - File opened for writing.
+ *
+ * @return  FR_OK, FR_DENIED on volume full, or the f_write/f_sync error.
+ */
+FRESULT ACQ_Poll(FIL *fp)
+{
+    FRESULT res = FR_OK;
+    UINT bw;
+
+    if (!Full[Next]) return FR_OK;
+
+    CLKGOV_Set(CLKGOV_BUSY);
+    while (Full[Next]) {
+        res = f_write(fp, (BYTE *)Ring + Next * ACQ_BLOCK_SIZE, ACQ_BLOCK_SIZE, &bw);
+        if (res == FR_OK && bw != ACQ_BLOCK_SIZE) res = FR_DENIED;
+        if (res != FR_OK) break;
+
+        Full[Next] = 0;     /* Release the half only after it is on the card */
+        Next ^= 1;
+
+        if (++ACQ_Stat.Blocks % ACQ_SYNC_BLOCKS == 0) {
+            res = f_sync(fp);
+            if (res != FR_OK) break;
+        }
+    }
+    CLKGOV_Set(CLKGOV_IDLE);
+
+    return res;
+}
+
+/* Hands a filled half of the record ring to the writer */
+static void filled(uint8_t half)
+{
+    if (Full[half]) ACQ_Stat.Overruns++;    /* Writer has not released it yet */
+    Full[half] = 1;
+}
+
+#if ACQ_OSR_LOG2
+/* Sums each channel over 2^k scans of a raw half into records */
+static void reduce(const uint16_t *raw)
+{
+    uint32_t sum[ACQ_CHANNELS];
+    uint16_t r, s;
+    uint8_t c;
+
+    for (r = 0; r < (ACQ_RAW_SCANS >> ACQ_OSR_LOG2); r++) {
+        for (c = 0; c < ACQ_CHANNELS; c++) sum[c] = 0;
+        for (s = 0; s < (1 << ACQ_OSR_LOG2); s++, raw += ACQ_CHANNELS) {
+            for (c = 0; c < ACQ_CHANNELS; c++) sum[c] += raw[c];
+        }
+        for (c = 0; c < ACQ_CHANNELS; c++) {
+            Ring[Out++] = (uint16_t)(sum[c] >> ACQ_OSR_SHIFT);
+            if (Out == ACQ_BLOCK_SIZE / 2) {
+                filled(0);
+            } else if (Out == ACQ_BLOCK_SIZE) {
+                Out = 0;
+                filled(1);
+            }
+        }
+    }
+}
+
+#if SCHED_ENABLE
+/* Reduces the raw halves in the order DMA fills them, it does not call FatFs */
+static uint8_t reduce_task(sched_task_t *t)
+{
+    PT_BEGIN(t);
+    while (1) {
+        PT_WAIT_UNTIL(t, RawFull[RawNext]);
+        reduce(Raw + RawNext * RAW_WORDS);
+        RawFull[RawNext] = 0;   /* DMA may refill it from now on */
+        RawNext ^= 1;
+    }
+    PT_END(t);
+}
+
+/* Hands a filled raw half to reduce_task */
+static void raw_filled(uint8_t half)
+{
+    if (RawFull[half]) ACQ_Stat.RawOverruns++;  /* Task has not reduced it yet */
+    RawFull[half] = 1;
+}
+#endif
+#endif
+
+/*********************************************************************
+ * @fn      DMA1_Channel1_IRQHandler
+ *
+ * @brief   Hands the half just filled by DMA to the writer, or reduces
+ *        the raw half just filled into records when oversampling (hands
+ *        it to reduce_task with SCHED_ENABLE).
+ *
+ * @return  none
+ */
+void DMA1_Channel1_IRQHandler(void)
+{
+    uint32_t f = DMA1->INTFR & (DMA1_IT_GL1 | DMA1_IT_TC1 | DMA1_IT_HT1 | DMA1_IT_TE1);
+
+    DMA1->INTFCR = f;
+
+#if ACQ_OSR_LOG2 && SCHED_ENABLE
+    if (f & DMA1_IT_HT1) raw_filled(0);
+    if (f & DMA1_IT_TC1) raw_filled(1);
+#elif ACQ_OSR_LOG2
+    if (f & DMA1_IT_HT1) reduce(Raw);
+    if (f & DMA1_IT_TC1) reduce(Raw + RAW_WORDS);
+#else
+    if (f & DMA1_IT_HT1) filled(0);
+    if (f & DMA1_IT_TC1) filled(1);
+#endif
+}
+
+#endif /* ACQ_ENABLE */
@@ -0,0 +1,124 @@
+/*********************************************************************************
+ * File Name          : acq.h
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Timer triggered ADC acquisition to SD card.
+ *********************************************************************************
+ * TIM2 update (TRGO) starts every scan of the ACQ_CHANNELS channels of
+ * ACQ_CHANNEL_LIST, DMA1 channel 1 stores the results, and the half-transfer/
+ * transfer-complete interrupts hand each finished ACQ_BLOCK_SIZE half of the
+ * ring to ACQ_Poll. A half that is refilled before it was written is counted
+ * as an overrun. The default 256-byte halves are copied into the FatFs window
+ * (FF_FS_TINY), which goes to the card as one whole sector once the next half
+ * starts a new sector, so the ring costs 512 bytes of RAM rather than 1KB; it
+ * holds 16ms of data at 8kHz on one channel. 512-byte halves are written
+ * straight to the card.
+ *
+ * The file is a stream of fixed-width records, one 16-bit word per channel in
+ * list order, which run on across sector boundaries. Without oversampling
+ * DMA writes the records straight into the ring at ACQ_RATE_HZ.
+ *
+ * With ACQ_OSR_LOG2 = k, DMA fills a small raw ring of ACQ_RAW_SCANS scans per
+ * half instead, and its interrupts add up each channel over 2^k scans and
+ * store sum >> ACQ_OSR_SHIFT in the record ring, at ACQ_RATE_HZ / 2^k:
+ *
+ *   ACQ_OSR_SHIFT = k / 2    oversampling, 12 + k/2 bit results (k even)
+ *   ACQ_OSR_SHIFT = k        decimating average, 12 bit results
+ *
+ * Either way the card sees 2^k times fewer bytes than the ADC produces.
+ *
+ * With SCHED_ENABLE the interrupts only hand the raw halves over and the sums
+ * are done by a SCHED_NESTABLE task, so they also run while disk_write waits
+ * for the card (sched_yield in wait_ready) instead of in the DMA interrupt.
+ * The caller runs sched_poll next to ACQ_Poll.
+ *
+ * The TIM2 prescaler takes ACQ_RATE_HZ down to 1Hz. The top is the ADC: a
+ * conversion takes 26 ADC clocks (ACQ_SAMPLE_TIME) at 12MHz, about 460k per
+ * second at 48MHz, so ACQ_RATE_HZ <= 460kHz / ACQ_CHANNELS and the record
+ * rate <= 460kHz / (ACQ_CHANNELS << ACQ_OSR_LOG2).
+ *******************************************************************************/
+#ifndef __ACQ_H
+#define __ACQ_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "debug.h"
+#include "ff.h"
+
+/* Acquisition Definition */
+#ifndef ACQ_ENABLE
+#define ACQ_ENABLE          0
+#endif
+
+#ifndef ACQ_RATE_HZ
+#define ACQ_RATE_HZ         8000                    /* Scan rate, 1Hz..460kHz / ACQ_CHANNELS at 48MHz */
+#endif
+
+#ifndef ACQ_CHANNEL_LIST
+#define ACQ_CHANNELS        1                       /* Channels scanned, 1..8 */
+#define ACQ_CHANNEL_LIST    ADC_Channel_2           /* A2 @ PC4, pins are set to analog input */
+#endif
+
+#ifndef ACQ_OSR_LOG2
+#define ACQ_OSR_LOG2        0                       /* Scans per record, log2 (0..6) */
+#endif
+
+#ifndef ACQ_OSR_SHIFT
+#define ACQ_OSR_SHIFT       (ACQ_OSR_LOG2 / 2)      /* Right shift of the 2^k sums */
+#endif
+
+#ifndef ACQ_RAW_SCANS
+#define ACQ_RAW_SCANS       ((1 << ACQ_OSR_LOG2) < 16 ? 16 : (1 << ACQ_OSR_LOG2))   /* Scans per raw half */
+#endif
+
+#ifndef ACQ_SAMPLE_TIME
+#define ACQ_SAMPLE_TIME     ADC_SampleTime_15Cycles /* 26 ADC clocks per conversion at 12MHz */
+#endif
+
+#ifndef ACQ_BLOCK_SIZE
+#define ACQ_BLOCK_SIZE      256                     /* Bytes handed to the writer at a time, 256 or 512 */
+#endif
+
+#ifndef ACQ_SYNC_BLOCKS
+#define ACQ_SYNC_BLOCKS     (32768 / ACQ_BLOCK_SIZE)    /* f_sync interval in blocks (32KB) */
+#endif
+
+#define ACQ_RECORD_SIZE     (2 * ACQ_CHANNELS)      /* Bytes per record in the file */
+
+#if (ACQ_BLOCK_SIZE != 256) && (ACQ_BLOCK_SIZE != 512)
+#error ACQ_BLOCK_SIZE must be 256 or 512
+#endif
+#if (ACQ_CHANNELS < 1) || (ACQ_CHANNELS > 8)
+#error ACQ_CHANNELS must be 1 to 8
+#endif
+#if (ACQ_OSR_LOG2 > 6) || (ACQ_OSR_SHIFT > ACQ_OSR_LOG2) || (ACQ_OSR_LOG2 - ACQ_OSR_SHIFT > 4)
+#error ACQ_OSR_LOG2 up to 6, and the shifted sums must fit 16 bits
+#endif
+#if ACQ_OSR_LOG2 && ((ACQ_RAW_SCANS % (1 << ACQ_OSR_LOG2)) || (ACQ_RAW_SCANS * ACQ_CHANNELS > 128))
+#error ACQ_RAW_SCANS must be a multiple of 2^ACQ_OSR_LOG2, at most 128 words per raw half
+#endif
+
+/* Acquisition statistics */
+typedef struct
+{
+    uint32_t Blocks;        /* Blocks written to the file */
+    uint32_t Overruns;      /* Blocks refilled by DMA before they were written */
+    uint32_t RawOverruns;   /* Raw halves refilled before the reduce task took them */
+} ACQ_StatTypeDef;
+
+#if ACQ_ENABLE
+extern volatile ACQ_StatTypeDef ACQ_Stat;
+
+void    ACQ_Init(void);
+void    ACQ_Start(void);
+void    ACQ_Stop(void);
+FRESULT ACQ_Poll(FIL *fp);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ACQ_H */
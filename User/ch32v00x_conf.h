@@ -29,6 +29,7 @@
 #include <ch32v00x_usart.h>
 #include <ch32v00x_wwdg.h>
 #include <ch32v00x_opa.h>
+#include <ch32v00x_fast.h>
 
 
 
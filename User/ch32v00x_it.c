@@ -10,9 +10,14 @@
 * microcontroller manufactured by Nanjing Qinheng Microelectronics.
 *******************************************************************************/
 #include <ch32v00x_it.h>
+#include "ff.h"
+#include "diskio.h"
+#include "prof.h"
+#include "i2cq.h"
 
 void NMI_Handler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
 void HardFault_Handler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
+void SysTick_Handler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
 
 /*********************************************************************
  * @fn      NMI_Handler
@@ -39,4 +44,19 @@ void HardFault_Handler(void)
   }
 }
 
+/*********************************************************************
+ * @fn      SysTick_Handler
+ *
+ * @brief   This function handles the 1ms SysTick tick.
+ *
+ * @return  none
+ */
+void SysTick_Handler(void)
+{
+  Delay_Tick();
+  PROF_Sample(__get_MEPC());
+  disk_timerproc();
+  I2CQ_Timerproc();
+}
+
 
@@ -0,0 +1,144 @@
+/*********************************************************************************
+ * File Name          : clkgov.c
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Runtime system clock governor.
+ *******************************************************************************/
+#include "clkgov.h"
+
+#if CLKGOV_ENABLE
+
+static CLKGOV_ClientTypeDef Clients[CLKGOV_CLIENTS];
+static uint8_t Level;
+static uint32_t Osc;                /* RCC_SW_HSI or RCC_SW_HSE */
+
+static void delay_client(uint32_t old_hz, uint32_t new_hz)
+{
+    Delay_Update();
+}
+
+/* BRR is HCLK / baud, scale it in kHz to stay within 32 bits */
+static void usart_client(uint32_t old_hz, uint32_t new_hz)
+{
+    uint32_t old_khz = old_hz / 1000;
+
+    USART1->BRR = (uint16_t)((USART1->BRR * (new_hz / 1000) + old_khz / 2) / old_khz);
+}
+
+/* Same register sequences as SetSysClockTo_xxx in system_ch32v00x.c */
+static void set_clock(uint8_t level)
+{
+    if (level == CLKGOV_48MHZ) {
+        FLASH->ACTLR = (FLASH->ACTLR & ~FLASH_ACTLR_LATENCY) | FLASH_ACTLR_LATENCY_1;
+        RCC->CFGR0 = (RCC->CFGR0 & ~RCC_HPRE) | RCC_HPRE_DIV1;
+
+        /* PLL entry follows the oscillator, it can only change with the PLL off */
+        RCC->CFGR0 = (RCC->CFGR0 & ~RCC_PLLSRC) | (Osc == RCC_SW_HSE ? RCC_PLLSRC_HSE_Mul2 : RCC_PLLSRC_HSI_Mul2);
+        RCC->CTLR |= RCC_PLLON;
+        while ((RCC->CTLR & RCC_PLLRDY) == 0);
+        RCC->CFGR0 = (RCC->CFGR0 & ~RCC_SW) | RCC_SW_PLL;
+        while ((RCC->CFGR0 & RCC_SWS) != RCC_SWS_PLL);
+    } else {
+        RCC->CFGR0 = (RCC->CFGR0 & ~RCC_SW) | Osc;
+        while ((RCC->CFGR0 & RCC_SWS) != (Osc << 2));
+        RCC->CFGR0 = (RCC->CFGR0 & ~RCC_HPRE) | (level == CLKGOV_8MHZ ? RCC_HPRE_DIV3 : RCC_HPRE_DIV1);
+        RCC->CTLR &= ~RCC_PLLON;
+        FLASH->ACTLR = (FLASH->ACTLR & ~FLASH_ACTLR_LATENCY) | FLASH_ACTLR_LATENCY_0;
+    }
+}
+
+/*********************************************************************
+ * @fn      CLKGOV_Init
+ *
+ * @brief   Takes over the clock left by SystemInit and registers the
+ *        Delay and USART1 clients. Call it after Delay_Init and the
+ *        USART1 initialization.
+ *
+ * @return  none
+ */
+void CLKGOV_Init(void)
+{
+    uint32_t sws = RCC->CFGR0 & RCC_SWS;
+
+    if (sws == RCC_SWS_PLL) {
+        Osc = (RCC->CFGR0 & RCC_PLLSRC) ? RCC_SW_HSE : RCC_SW_HSI;
+    } else {
+        Osc = sws >> 2;
+    }
+    SystemCoreClockUpdate();
+    if (SystemCoreClock > 24000000) Level = CLKGOV_48MHZ;
+    else if (SystemCoreClock > 8000000) Level = CLKGOV_24MHZ;
+    else Level = CLKGOV_8MHZ;
+
+    CLKGOV_Register(delay_client);
+    CLKGOV_Register(usart_client);
+}
+
+/*********************************************************************
+ * @fn      CLKGOV_Register
+ *
+ * @brief   Adds a client called after each clock switch. A client that
+ *        is already registered is not added again.
+ *
+ * @param   client - Function recomputing the dividers of a peripheral.
+ *
+ * @return  none
+ */
+void CLKGOV_Register(CLKGOV_ClientTypeDef client)
+{
+    uint8_t i;
+
+    for (i = 0; i < CLKGOV_CLIENTS; i++) {
+        if (Clients[i] == client) return;
+        if (Clients[i] == 0) {
+            Clients[i] = client;
+            return;
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      CLKGOV_Set
+ *
+ * @brief   Switches the system clock and updates the clients. Call it
+ *        between transfers, not from an interrupt.
+ *
+ * @param   level - CLKGOV_8MHZ, CLKGOV_24MHZ or CLKGOV_48MHZ.
+ *
+ * @return  none
+ */
+void CLKGOV_Set(uint8_t level)
+{
+    uint32_t old_hz = SystemCoreClock;
+    uint8_t i;
+
+    if (level == Level || level > CLKGOV_48MHZ) return;
+
+    USART_Printf_Flush();
+    if (USART1->CTLR1 & USART_CTLR1_UE) {
+        while (!(USART1->STATR & USART_FLAG_TC));   /* Last byte has left at the old baud rate */
+    }
+
+    __disable_irq();
+    set_clock(level);
+    Level = level;
+    SystemCoreClockUpdate();
+    for (i = 0; i < CLKGOV_CLIENTS && Clients[i]; i++) {
+        Clients[i](old_hz, SystemCoreClock);
+    }
+    __enable_irq();
+}
+
+/*********************************************************************
+ * @fn      CLKGOV_Get
+ *
+ * @brief   Returns the current level.
+ *
+ * @return  CLKGOV_8MHZ, CLKGOV_24MHZ or CLKGOV_48MHZ
+ */
+uint8_t CLKGOV_Get(void)
+{
+    return Level;
+}
+
+#endif /* CLKGOV_ENABLE */
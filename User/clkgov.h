@@ -0,0 +1,74 @@
+/*********************************************************************************
+ * File Name          : clkgov.h
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Runtime system clock governor.
+ *********************************************************************************
+ * SystemInit starts the clock chosen by SYSCLK_FREQ_xxx in system_ch32v00x.c.
+ * CLKGOV_Set then moves between the three configurations of SetSysClockTo_xxx
+ * on the same oscillator (HSI or HSE, as SystemInit left it):
+ *
+ *   CLKGOV_8MHZ     oscillator / 3, PLL off, flash 0 wait state
+ *   CLKGOV_24MHZ    oscillator,     PLL off, flash 0 wait state
+ *   CLKGOV_48MHZ    PLL x 2,                 flash 1 wait state
+ *
+ * After a switch every registered client is called, with interrupts masked,
+ * to recompute its dividers so that its rate does not change. CLKGOV_Init
+ * registers the Delay timebase (1ms tick, Delay_Us/Delay_Ms) and the USART1
+ * baud rate; the disk driver keeps its SPI clock and ACQ its sample rate.
+ * The printf output is flushed before the switch, but a byte being received
+ * on USART1 during it may be lost.
+ *
+ * SysTick counts HCLK/8, so raw SysTick intervals (PERF, PROF, DTRACE, DSTAT,
+ * SDBENCH) are in the units of the clock in use when they were measured.
+ *******************************************************************************/
+#ifndef __CLKGOV_H
+#define __CLKGOV_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "debug.h"
+
+/* Clock Governor Definition */
+#ifndef CLKGOV_ENABLE
+#define CLKGOV_ENABLE       0
+#endif
+
+#ifndef CLKGOV_CLIENTS
+#define CLKGOV_CLIENTS      6                       /* Registered clients, 2 are taken by CLKGOV_Init */
+#endif
+
+#ifndef CLKGOV_BUSY
+#define CLKGOV_BUSY         CLKGOV_48MHZ            /* Level for card transfers */
+#endif
+
+#ifndef CLKGOV_IDLE
+#define CLKGOV_IDLE         CLKGOV_8MHZ             /* Level while waiting for samples */
+#endif
+
+/* Levels */
+#define CLKGOV_8MHZ         0
+#define CLKGOV_24MHZ        1
+#define CLKGOV_48MHZ        2
+
+/* Called after a switch with the old and the new HCLK in Hz */
+typedef void (*CLKGOV_ClientTypeDef)(uint32_t old_hz, uint32_t new_hz);
+
+#if CLKGOV_ENABLE
+void    CLKGOV_Init(void);
+void    CLKGOV_Register(CLKGOV_ClientTypeDef client);
+void    CLKGOV_Set(uint8_t level);
+uint8_t CLKGOV_Get(void);
+#else
+#define CLKGOV_Init()                   ((void)0)
+#define CLKGOV_Register(client)         ((void)0)
+#define CLKGOV_Set(level)               ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CLKGOV_H */
@@ -0,0 +1,33 @@
+/*********************************************************************************
+ * File Name          : crc32.c
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : CRC-32 (IEEE 802.3, as zlib and cksum -a crc32b).
+ *******************************************************************************/
+#include "crc32.h"
+
+/*********************************************************************
+ * @fn      CRC32_Update
+ *
+ * @brief   Continues a CRC-32 over a buffer.
+ *
+ * @param   crc - Result of the previous call, 0 to start.
+ *          buf - Data.
+ *          len - Bytes in buf.
+ *
+ * @return  CRC-32 of everything passed so far
+ */
+uint32_t CRC32_Update(uint32_t crc, const void *buf, uint32_t len)
+{
+    const uint8_t *p = buf;
+    uint8_t i;
+
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        for (i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
@@ -0,0 +1,28 @@
+/*********************************************************************************
+ * File Name          : crc32.h
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : CRC-32 (IEEE 802.3, as zlib and cksum -a crc32b).
+ *********************************************************************************
+ * Bitwise, without a table: about 8 cycles per bit, small in flash and RAM.
+ * The value is continued over several buffers by passing the previous result:
+ *
+ *   crc = CRC32_Update(0, a, na);
+ *   crc = CRC32_Update(crc, b, nb);
+ *******************************************************************************/
+#ifndef __CRC32_H
+#define __CRC32_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include <stdint.h>
+
+uint32_t CRC32_Update(uint32_t crc, const void *buf, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CRC32_H */
@@ -11,17 +11,34 @@
 #include "diskio.h"		/* Declarations of disk functions */
 #include "debug.h"
 #include "ff.h"
+#include "sched.h"
+#include "perf.h"
+#include "dtrace.h"
+#include "clkgov.h"
+#include "pfail.h"
+#include <string.h>
 
-#define CS_HIGH() GPIOC->BSHR = GPIO_Pin_3
-#define CS_LOW() GPIOC->BCR = GPIO_Pin_3
+#define CS_HIGH() GPIO_SetBits_Fast(GPIOC, GPIO_Pin_3)
+#define CS_LOW() GPIO_ResetBits_Fast(GPIOC, GPIO_Pin_3)
 
 #define MMC_WP 0
 #define MMC_CD 1
 
-#define power_on()
-#define power_off()
-#define FCLK_SLOW()
-#define FCLK_FAST()
+#ifndef MMC_POWER_ON
+#define MMC_POWER_ON()      /* Card supply switch, none by default */
+#define MMC_POWER_OFF()
+#endif
+
+#ifndef MMC_INIT_MS
+#define MMC_INIT_MS 1000    /* ACMD41 timeout, bounds the cost of disk_initialize */
+#endif
+
+#define power_on()  MMC_POWER_ON()
+#define power_off() MMC_POWER_OFF()
+#define SCLK_SLOW   400000      /* Identification mode limit */
+#define SCLK_FAST   12000000
+#define FCLK_SLOW() set_sclk(SCLK_SLOW)     /* SCLK = PCLK/128 (375kHz at 48MHz) for init */
+#define FCLK_FAST() set_sclk(SCLK_FAST)     /* SCLK = PCLK/4 (12MHz at 48MHz), PCLK/2 below */
 
 static volatile
 DSTATUS Stat = STA_NOINIT;  /* Disk status */
@@ -32,22 +49,76 @@ UINT Timer1, Timer2;        /* 1000Hz decrement timer */
 static
 UINT CardType;
 
-static BYTE xchg_spi (
-    BYTE dat    /* Data to send */
+static
+DWORD Sclk;                 /* SCLK limit in use, kept across clock switches */
+
+static volatile
+BYTE Busy;                  /* disk_claim nesting, the card is in use while not 0 */
+
+#if DSTAT_ENABLE
+static DSTAT Dstat;
+
+#define DSTAT_NOW()     SysTick->CNT
+#define DSTAT_INC(m)    (Dstat.m++)
+#define DSTAT_ADD(m, n) (Dstat.m += (n))
+
+static
+void dstat_time (
+    BYTE cls,       /* DSTAT_xxx class */
+    DWORD t0        /* DSTAT_NOW() at the start */
 )
 {
-    uint8_t ret;
-    while(SPI1->STATR & SPI_I2S_FLAG_BSY);
-    SPI1->DATAR = dat;              /* Start an SPI transaction */
-    while (!(SPI1->STATR & SPI_I2S_FLAG_TXE));  /* Wait for end of the transaction */
-    asm volatile("nop");
-    while(!(SPI1->STATR & SPI_I2S_FLAG_RXNE));
-    ret = (BYTE)SPI1->DATAR;       /* Return received byte */
-    while(SPI1->STATR & SPI_I2S_FLAG_BSY);
-    return ret;
+    DWORD t = (DSTAT_NOW() - t0) >> DSTAT_SHIFT;
+    BYTE b = 0;
+    WORD *h;
+
+    while (t && b < DSTAT_BUCKETS - 1) {    /* Bucket = bit length */
+        t >>= 1; b++;
+    }
+    h = &Dstat.hist[cls][b];
+    if (*h != 0xFFFF) (*h)++;
 }
+#else
+#define DSTAT_NOW()     0
+#define DSTAT_INC(m)    ((void)0)
+#define DSTAT_ADD(m, n) ((void)0)
+#define dstat_time(cls, t0) ((void)(cls), (void)(t0))
+#endif
+
+/* Fastest SCLK = PCLK / 2^(BR+1) not above hz */
+static
+void set_sclk (
+    DWORD hz
+)
+{
+    WORD br = 0;
 
+    Sclk = hz;
+    while (br < 7 && (SystemCoreClock >> (br + 1)) > hz) br++;
+    SPI1->CTLR1 = (SPI1->CTLR1 & ~SPI_CTLR1_BR) | (br << 3);
+}
+
+#if CLKGOV_ENABLE
 static
+void spi_clock (
+    uint32_t old_hz,
+    uint32_t new_hz
+)
+{
+    if (Sclk) set_sclk(Sclk);
+}
+#endif
+
+static RAMFUNC
+BYTE xchg_spi (
+    BYTE dat    /* Data to send */
+)
+{
+    DSTAT_INC(spi_bytes);
+    return SPI_Xchg_Fast(SPI1, dat);    /* Inlined, nothing called from flash */
+}
+
+static RAMFUNC
 void xmit_spi_multi (
     const BYTE* buff,   /* Data to be sent */
     UINT cnt            /* Number of bytes to send */
@@ -58,7 +129,7 @@ void xmit_spi_multi (
     } while (cnt -= 1);
 }
 
-static
+static RAMFUNC
 void rcvr_spi_multi (
     BYTE* buff,     /* Buffer to store received data */
     UINT cnt        /* Number of bytes to receive */
@@ -73,12 +144,16 @@ static
 int wait_ready (void)
 {
     BYTE d;
+    DWORD t0 = DSTAT_NOW();
 
     Timer2 = 500;   /* Wait for ready in timeout of 500ms */
     do {
         d = xchg_spi(0xFF);
+        if (d != 0xFF) sched_yield();   /* Let the other tasks run while the card is busy */
     } while ((d != 0xFF) && Timer2);
 
+    dstat_time(DSTAT_BUSY, t0);
+    if (d != 0xFF) DSTAT_INC(busy_timeouts);
     return (d == 0xFF) ? 1 : 0;
 }
 
@@ -113,9 +188,13 @@ int rcvr_datablock (    /* 1:OK, 0:Failed */
     Timer1 = 100;
     do {                            /* Wait for data packet in timeout of 100ms */
         token = xchg_spi(0xFF);
+        if (token == 0xFF) sched_yield();   /* Let the other tasks run while the card is busy */
     } while ((token == 0xFF) && Timer1);
 
-    if(token != 0xFE) return 0;     /* If not valid data token, retutn with error */
+    if(token != 0xFE) {             /* If not valid data token, retutn with error */
+        if (token == 0xFF) DSTAT_INC(token_timeouts); else DSTAT_INC(token_errors);
+        return 0;
+    }
 
     rcvr_spi_multi(buff, btr);      /* Receive the data block into buffer */
     xchg_spi(0xFF);                 /* Discard CRC */
@@ -141,8 +220,10 @@ int xmit_datablock (    /* 1:OK, 0:Failed */
         xchg_spi(0xFF);             /* CRC (Dummy) */
         xchg_spi(0xFF);
         resp = xchg_spi(0xFF);      /* Receive a data response */
-        if ((resp & 0x1F) != 0x05)
+        if ((resp & 0x1F) != 0x05) {
+            DSTAT_INC(wr_rejects);
             return 0;    /* If not accepted, return with error */
+        }
     }
 
     return 1;
@@ -187,6 +268,7 @@ BYTE send_cmd (
         res = xchg_spi(0xFF);
     } while ((res & 0x80) && --n);
 
+    if (res & 0x80) DSTAT_INC(cmd_timeouts);
     return res;         /* Return with the response value */
 }
 
@@ -209,17 +291,19 @@ DSTATUS disk_initialize (
     if (pdrv != 0) return STA_NOINIT;   /* Supports only single drive */
     if (Stat & STA_NODISK) return Stat; /* No card in the socket */
 
+    disk_claim();
     power_on();                         /* Initialize memory card interface */
+    CLKGOV_Register(spi_clock);         /* Keep SCLK on clock switches */
     FCLK_SLOW();
     for (n = 10; n; n--) xchg_spi(0xFF);    /* 80 dummy clocks */
 
     ty = 0;
     if (send_cmd(CMD0, 0) == 1) {           /* Enter Idle state */
-        Timer1 = 1000;                      /* Initialization timeout of 1000 msec */
+        Timer1 = MMC_INIT_MS;               /* Initialization timeout */
         if (send_cmd(CMD8, 0x1AA) == 1) {   /* SDv2? */
             for (n = 0; n < 4; n++) ocr[n] = xchg_spi(0xFF);            /* Get trailing return value of R7 resp */
             if (ocr[2] == 0x01 && ocr[3] == 0xAA) {             /* The card can work at vdd range of 2.7-3.6V */
-                while (Timer1 && send_cmd(ACMD41, 0x40000000)); /* Wait for leaving idle state (ACMD41 with HCS bit) */
+                while (Timer1 && send_cmd(ACMD41, 0x40000000)) DSTAT_INC(init_retries);   /* Wait for leaving idle state (ACMD41 with HCS bit) */
                 if (Timer1 && send_cmd(CMD58, 0) == 0) {            /* Check CCS bit in the OCR */
                     for (n = 0; n < 4; n++) ocr[n] = xchg_spi(0xFF);
                     ty = (ocr[0] & 0x40) ? CT_SD2|CT_BLOCK : CT_SD2;    /* SDv2+ */
@@ -231,7 +315,7 @@ DSTATUS disk_initialize (
             } else {
                 ty = CT_MMC; cmd = CMD1;    /* MMCv3 */
             }
-            while (Timer1 && send_cmd(cmd, 0));     /* Wait for leaving idle state */
+            while (Timer1 && send_cmd(cmd, 0)) DSTAT_INC(init_retries);   /* Wait for leaving idle state */
             if (!Timer1 || send_cmd(CMD16, 512) != 0) ty = 0;   /* Set read/write block length to 512 */
         }
     }
@@ -244,6 +328,7 @@ DSTATUS disk_initialize (
     } else {        /* Function failed */
         power_off();    /* Deinitialize interface */
     }
+    disk_release();
 
     return Stat;
 }
@@ -256,10 +341,15 @@ DRESULT disk_read (
 )
 {
     DWORD sect = (DWORD)sector;
+    DWORD t0 = DSTAT_NOW();
+    UINT n = count;
 
 
+    PERF_BEGIN(PERF_DISK_READ);
     if (pdrv || !count) return RES_PARERR;
+    DTRACE_Record(DTRACE_OP_READ, sect, count);
     if (Stat & STA_NOINIT) return RES_NOTRDY;
+    disk_claim();
 
     if (!(CardType & CT_BLOCK)) sect *= 512;    /* Convert to byte address if needed */
 
@@ -279,7 +369,11 @@ DRESULT disk_read (
         }
     }
     mmc_deselect();
+    disk_release();
 
+    dstat_time(n == 1 ? DSTAT_READ1 : DSTAT_READN, t0);
+    DSTAT_ADD(rd_sect, n - count);
+    if (count) DSTAT_INC(rd_errors);
     return count ? RES_ERROR : RES_OK;
 }
 
@@ -291,11 +385,16 @@ DRESULT disk_write (
 )
 {
     DWORD sect = (DWORD)sector;
+    DWORD t0 = DSTAT_NOW();
+    UINT n = count;
 
 
+    PERF_BEGIN(PERF_DISK_WRITE);
     if (pdrv || !count) return RES_PARERR;
+    DTRACE_Record(DTRACE_OP_WRITE, sect, count);
     if (Stat & STA_NOINIT) return RES_NOTRDY;
     if (Stat & STA_PROTECT) return RES_WRPRT;
+    disk_claim();
 
     if (!(CardType & CT_BLOCK)) sect *= 512;    /* Convert to byte address if needed */
 
@@ -316,7 +415,11 @@ DRESULT disk_write (
         }
     }
     mmc_deselect();
+    disk_release();
 
+    dstat_time(n == 1 ? DSTAT_WRITE1 : DSTAT_WRITEN, t0);
+    DSTAT_ADD(wr_sect, n - count);
+    if (count) DSTAT_INC(wr_errors);
     return count ? RES_ERROR : RES_OK;
 }
 
@@ -332,8 +435,37 @@ DRESULT disk_ioctl (
 
 
     if (pdrv) return RES_PARERR;
+
+#if DSTAT_ENABLE
+    switch (cmd) {  /* Controls that do not access the card */
+    case MMC_GET_DSTAT :    /* Copy I/O statistics (DSTAT) */
+        *(DSTAT*)buff = Dstat;
+        return RES_OK;
+
+    case MMC_RESET_DSTAT :  /* Clear I/O statistics */
+        memset(&Dstat, 0, sizeof Dstat);
+        return RES_OK;
+    }
+#endif
+
+    DTRACE_Record(DTRACE_OP_IOCTL, cmd, 0);
+    if (cmd == CTRL_POWER) {    /* 0:Power off, 2:Get power state (disk_initialize powers on) */
+        if (*ptr == 0) {
+            disk_claim();
+            mmc_deselect();
+            power_off();
+            Stat |= STA_NOINIT;
+            disk_release();
+        } else if (*ptr == 2) {
+            *(ptr + 1) = (Stat & STA_NOINIT) ? 0 : 1;
+        } else {
+            return RES_PARERR;
+        }
+        return RES_OK;
+    }
     if (Stat & STA_NOINIT) return RES_NOTRDY;
 
+    disk_claim();
     res = RES_ERROR;
     switch (cmd) {
     case CTRL_SYNC :    /* Flush write-back cache, Wait for end of internal process */
@@ -401,6 +533,12 @@ DRESULT disk_ioctl (
         }
         break;
 
+    case MMC_READ_STREAM :  /* Start a multiple block read, the caller clocks out the blocks (fwup.c) */
+        csz = (DWORD)*(LBA_t*)buff;
+        if (!(CardType & CT_BLOCK)) csz *= 512;
+        if (send_cmd(CMD18, csz) == 0) return RES_OK;  /* Selected and claimed until the caller's CMD12 and disk_release */
+        break;
+
     case MMC_GET_SDSTAT :   /* Receive SD statsu as a data block (64 bytes) */
         if ((CardType & CT_SD2) && send_cmd(ACMD13, 0) == 0) {  /* SD_STATUS */
             xchg_spi(0xFF);
@@ -408,21 +546,33 @@ DRESULT disk_ioctl (
         }
         break;
 
-//    case CTRL_POWER_OFF :   /* Power off */
-//        power_off();
-//        Stat |= STA_NOINIT;
-//        res = RES_OK;
-//        break;
-
     default:
         res = RES_PARERR;
     }
 
     mmc_deselect();
+    disk_release();
 
     return res;
 }
 
+/* Card access outside FatFs: a PVD_IRQHandler (pfail.c) that interrupts
+   one waits for disk_release instead of running its f_sync in the middle */
+void disk_claim (void)
+{
+    Busy++;
+}
+
+void disk_release (void)
+{
+    if (--Busy == 0) PFAIL_DiskIdle();
+}
+
+int disk_busy (void)
+{
+    return Busy != 0;
+}
+
 void disk_timerproc (void)
 {
     BYTE s;
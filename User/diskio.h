@@ -31,6 +31,10 @@ DSTATUS disk_status (BYTE pdrv);
 DRESULT disk_read (BYTE pdrv, BYTE* buff, LBA_t sector, UINT count);
 DRESULT disk_write (BYTE pdrv, const BYTE* buff, LBA_t sector, UINT count);
 DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff);
+void disk_timerproc (void);
+void disk_claim (void);
+void disk_release (void);
+int disk_busy (void);
 
 
 /* Disk Status Bits (DSTATUS) */
@@ -61,6 +65,9 @@ DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff);
 #define MMC_GET_CID			12	/* Get CID */
 #define MMC_GET_OCR			13	/* Get OCR */
 #define MMC_GET_SDSTAT		14	/* Get SD status */
+#define MMC_GET_DSTAT		15	/* Get I/O statistics (DSTAT, needs DSTAT_ENABLE) */
+#define MMC_RESET_DSTAT		16	/* Clear I/O statistics */
+#define MMC_READ_STREAM		17	/* Start a multiple block read at the LBA in buff, the card stays selected and claimed (disk_busy): the caller ends it with CMD12, deselects and calls disk_release */
 #define ISDIO_READ			55	/* Read data form SD iSDIO register */
 #define ISDIO_WRITE			56	/* Write data to SD iSDIO register */
 #define ISDIO_MRITE			57	/* Masked write data to SD iSDIO register */
@@ -92,6 +99,36 @@ DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff);
 #define CMD55   (55)        /* APP_CMD */
 #define CMD58   (58)        /* READ_OCR */
 
+/* I/O statistics (MMC_GET_DSTAT) */
+#ifndef DSTAT_ENABLE
+#define DSTAT_ENABLE    0
+#endif
+
+#define DSTAT_SHIFT     6           /* Bucket 0 is below 2^DSTAT_SHIFT SysTick counts (10.7us at 48MHz) */
+#define DSTAT_BUCKETS   16          /* Bucket n is [2^(n-1), 2^n) times bucket 0, the last one is open */
+
+#define DSTAT_READ1     0           /* disk_read by CMD17 */
+#define DSTAT_READN     1           /* disk_read by CMD18 */
+#define DSTAT_WRITE1    2           /* disk_write by CMD24 */
+#define DSTAT_WRITEN    3           /* disk_write by CMD25 */
+#define DSTAT_BUSY      4           /* wait_ready */
+#define DSTAT_CLASSES   5
+
+typedef struct {
+    WORD hist[DSTAT_CLASSES][DSTAT_BUCKETS];    /* Latency histograms (saturating) */
+    DWORD rd_sect;          /* Sectors read */
+    DWORD wr_sect;          /* Sectors written */
+    DWORD spi_bytes;        /* Bytes clocked on the SPI, including polling */
+    WORD rd_errors;         /* Failed disk_read */
+    WORD wr_errors;         /* Failed disk_write */
+    WORD busy_timeouts;     /* wait_ready gave up (500ms) */
+    WORD token_timeouts;    /* No data token (100ms) */
+    WORD token_errors;      /* Data token other than 0xFE */
+    WORD cmd_timeouts;      /* No command response in 10 bytes */
+    WORD wr_rejects;        /* Data response other than accepted */
+    WORD init_retries;      /* ACMD41/CMD1 repeated until ready */
+} DSTAT;
+
 /* MMC card type flags (MMC_GET_TYPE) */
 #define CT_MMC      0x01        /* MMC ver 3 */
 #define CT_SD1      0x02        /* SD ver 1 */
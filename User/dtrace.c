@@ -0,0 +1,176 @@
+/*********************************************************************************
+ * File Name          : dtrace.c
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Disk access trace recorder.
+ *******************************************************************************/
+#include "dtrace.h"
+
+#if DTRACE_ENABLE
+
+#define REC_MAX     16      /* Longest record: op, dt, sector delta, count */
+
+DTRACE_StatTypeDef DTRACE_Stat;
+
+static uint8_t Ring[DTRACE_RING_SIZE];
+static uint16_t Head, Tail;         /* Free-running, Head - Tail bytes are queued */
+static uint8_t Active;
+static uint32_t Last;               /* DTRACE_NOW() of the previous record, rounded down */
+static uint32_t End;                /* Sector after the previous READ/WRITE */
+static uint32_t Pending;            /* Records lost since the last LOST record */
+
+static void put(uint8_t b)
+{
+    Ring[Head++ % DTRACE_RING_SIZE] = b;
+}
+
+static void put_varint(uint32_t v)
+{
+    while (v >= 0x80) {
+        put((uint8_t)v | 0x80);
+        v >>= 7;
+    }
+    put((uint8_t)v);
+}
+
+static void put_time(uint32_t now)
+{
+    uint32_t dt = (now - Last) >> DTRACE_TSHIFT;
+
+    Last += dt << DTRACE_TSHIFT;
+    put_varint(dt);
+}
+
+/*********************************************************************
+ * @fn      DTRACE_Start
+ *
+ * @brief   Clears the ring and starts a new stream.
+ *
+ * @return  none
+ */
+void DTRACE_Start(void)
+{
+    Head = Tail = 0;
+    End = 0;
+    Pending = 0;
+    DTRACE_Stat.Records = DTRACE_Stat.Lost = DTRACE_Stat.Bytes = 0;
+    Last = DTRACE_NOW();
+    put('D');
+    put('T');
+    put(DTRACE_VERSION);
+    put(DTRACE_TSHIFT);
+    Active = 1;
+}
+
+/*********************************************************************
+ * @fn      DTRACE_Stop
+ *
+ * @brief   Stops recording, the ring can still be flushed.
+ *
+ * @return  none
+ */
+void DTRACE_Stop(void)
+{
+    Active = 0;
+}
+
+/*********************************************************************
+ * @fn      DTRACE_Record
+ *
+ * @brief   Appends a record, or counts it as lost if the ring is full.
+ *
+ * @param   op - DTRACE_OP_READ, DTRACE_OP_WRITE or DTRACE_OP_IOCTL.
+ *          sector - Start sector, or the command code for DTRACE_OP_IOCTL.
+ *          count - Sector count (READ/WRITE).
+ *
+ * @return  none
+ */
+void DTRACE_Record(uint8_t op, uint32_t sector, uint32_t count)
+{
+    uint32_t now, d;
+
+    if (!Active) return;
+    if ((uint16_t)(Head - Tail) > DTRACE_RING_SIZE - REC_MAX * (Pending ? 2 : 1)) {
+        Pending++;
+        DTRACE_Stat.Lost++;
+        return;
+    }
+
+    now = DTRACE_NOW();
+    if (Pending) {
+        put(DTRACE_OP_LOST);
+        put_time(now);
+        put_varint(Pending);
+        Pending = 0;
+    }
+    if (op == DTRACE_OP_IOCTL) {
+        put(op);
+        put_time(now);
+        put((uint8_t)sector);
+    } else {
+        put(op | (count != 1 ? DTRACE_F_COUNT : 0));
+        put_time(now);
+        d = sector - End;
+        put_varint((d << 1) ^ (uint32_t)((int32_t)d >> 31));  /* Zigzag */
+        if (count != 1) put_varint(count);
+        End = sector + count;
+    }
+    DTRACE_Stat.Records++;
+}
+
+/*********************************************************************
+ * @fn      DTRACE_Flush
+ *
+ * @brief   Appends the queued trace bytes to a file. Recording is held
+ *        off meanwhile, so the file writes do not show in the trace.
+ *
+ * @param   fp - Open file, f_sync is left to the caller.
+ *
+ * @return  FR_OK, FR_DENIED on volume full, or the f_write error.
+ */
+FRESULT DTRACE_Flush(FIL *fp)
+{
+    FRESULT res = FR_OK;
+    uint8_t active = Active;
+    uint16_t n;
+    UINT bw;
+
+    Active = 0;
+    while (res == FR_OK && Head != Tail) {
+        n = (uint16_t)(Head - Tail);
+        if (n > DTRACE_RING_SIZE - Tail % DTRACE_RING_SIZE) n = DTRACE_RING_SIZE - Tail % DTRACE_RING_SIZE;
+        res = f_write(fp, &Ring[Tail % DTRACE_RING_SIZE], n, &bw);
+        Tail += (uint16_t)bw;
+        DTRACE_Stat.Bytes += bw;
+        if (res == FR_OK && bw != n) res = FR_DENIED;
+    }
+    Active = active;
+    return res;
+}
+
+/*********************************************************************
+ * @fn      DTRACE_Dump
+ *
+ * @brief   Prints the queued trace bytes in hex and empties the ring:
+ *
+ *            DTRC 44540106000401...
+ *            DTRC end records:12 lost:0
+ *
+ * @return  none
+ */
+void DTRACE_Dump(void)
+{
+    uint8_t i;
+
+    while (Head != Tail) {
+        printf("DTRC ");
+        for (i = 0; i < 32 && Head != Tail; i++) {
+            printf("%02x", Ring[Tail++ % DTRACE_RING_SIZE]);
+            DTRACE_Stat.Bytes++;
+        }
+        printf("\r\n");
+    }
+    printf("DTRC end records:%d lost:%d\r\n", DTRACE_Stat.Records, DTRACE_Stat.Lost);
+}
+
+#endif /* DTRACE_ENABLE */
@@ -0,0 +1,92 @@
+/*********************************************************************************
+ * File Name          : dtrace.h
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Disk access trace recorder.
+ *********************************************************************************
+ * disk_read, disk_write and disk_ioctl append one record per call to a RAM ring
+ * of DTRACE_RING_SIZE bytes. Records are delta-encoded and mostly 3 to 4 bytes
+ * long. DTRACE_Flush appends the ring to a file and DTRACE_Dump prints it over
+ * the console; the disk accesses of DTRACE_Flush itself are not recorded.
+ * Host/dtrace.py decodes either form and analyses the access pattern.
+ *
+ * Stream format (varint: 7 bits per byte, LSB first, bit 7 set if more follow):
+ *
+ *   'D' 'T' DTRACE_VERSION DTRACE_TSHIFT           once, at DTRACE_Start
+ *   op|flags  varint dt  [operands]                per record
+ *
+ *   dt is the time since the previous record in SysTick counts >> DTRACE_TSHIFT.
+ *   READ/WRITE:  zigzag varint (sector - end of the previous READ/WRITE),
+ *                varint count if DTRACE_F_COUNT is set (1 otherwise)
+ *   IOCTL:       command byte
+ *   LOST:        varint number of records dropped on a full ring
+ *******************************************************************************/
+#ifndef __DTRACE_H
+#define __DTRACE_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "debug.h"
+#include "ff.h"
+
+/* Disk Trace Definition */
+#ifndef DTRACE_ENABLE
+#define DTRACE_ENABLE       0
+#endif
+
+#ifndef DTRACE_RING_SIZE
+#define DTRACE_RING_SIZE    256                     /* Power of 2 */
+#endif
+
+#ifndef DTRACE_TSHIFT
+#define DTRACE_TSHIFT       6                       /* Time unit of 64 SysTick counts (10.7us at 48MHz) */
+#endif
+
+#ifndef DTRACE_NOW
+#define DTRACE_NOW()        (SysTick->CNT)
+#endif
+
+#if (DTRACE_RING_SIZE & (DTRACE_RING_SIZE - 1)) || (DTRACE_RING_SIZE > 0x8000)
+#error DTRACE_RING_SIZE must be a power of 2 up to 32768
+#endif
+
+#define DTRACE_VERSION      1
+
+/* Record types (low bits of the first byte) */
+#define DTRACE_OP_READ      0
+#define DTRACE_OP_WRITE     1
+#define DTRACE_OP_IOCTL     2
+#define DTRACE_OP_LOST      3
+#define DTRACE_OP_MASK      0x03
+#define DTRACE_F_COUNT      0x04                    /* Sector count follows */
+
+/* Trace statistics */
+typedef struct
+{
+    uint32_t Records;       /* Records put in the ring */
+    uint32_t Lost;          /* Records dropped on a full ring */
+    uint32_t Bytes;         /* Bytes flushed or dumped */
+} DTRACE_StatTypeDef;
+
+#if DTRACE_ENABLE
+extern DTRACE_StatTypeDef DTRACE_Stat;
+
+void    DTRACE_Start(void);
+void    DTRACE_Stop(void);
+void    DTRACE_Record(uint8_t op, uint32_t sector, uint32_t count);
+FRESULT DTRACE_Flush(FIL *fp);
+void    DTRACE_Dump(void);
+#else
+#define DTRACE_Start()                  ((void)0)
+#define DTRACE_Stop()                   ((void)0)
+#define DTRACE_Record(op, sector, count) ((void)0)
+#define DTRACE_Dump()                   ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DTRACE_H */
@@ -0,0 +1,303 @@
+/*********************************************************************************
+ * File Name          : ecap.c
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Timer input capture event logger to SD card.
+ *******************************************************************************/
+#include "ecap.h"
+#include "clkgov.h"
+
+#if ECAP_ENABLE
+
+#if !FF_FS_TINY
+#error Event capture needs FF_FS_TINY = 1 to fit the timestamp ring in RAM
+#endif
+
+void TIM1_UP_IRQHandler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
+void TIM1_CC_IRQHandler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
+void DMA1_Channel2_IRQHandler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
+
+#define HALF        (ECAP_BLOCK_SIZE / 4)       /* Timestamps per half */
+
+volatile ECAP_StatTypeDef ECAP_Stat;
+
+static uint16_t Ring[ECAP_RING];        /* Captures stored by DMA */
+static uint16_t Tail;                   /* Next capture to extend */
+static uint16_t Epoch;                  /* TIM1 overflows, upper half of the timestamps */
+static uint32_t Out[2 * HALF];          /* Two halves of ECAP_BLOCK_SIZE bytes */
+static uint16_t Pos;                    /* Out index of the next timestamp */
+static volatile uint8_t Full[2];        /* Half is filled and not yet written */
+static uint8_t Next;                    /* Half to be written next */
+
+/* TIM1 tick at ECAP_TICK_HZ from the current clock, from the next update on */
+static void ecap_timer(void)
+{
+    TIM1->PSC = (uint16_t)(SystemCoreClock / ECAP_TICK_HZ - 1);
+}
+
+/* Hands a filled half of the timestamp ring to the writer */
+static void filled(uint8_t half)
+{
+    if (Full[half]) ECAP_Stat.Overruns++;   /* Writer has not released it yet */
+    Full[half] = 1;
+}
+
+static void store(uint32_t t)
+{
+    Out[Pos++] = t;
+    ECAP_Stat.Events++;
+    if (Pos == HALF) {
+        filled(0);
+    } else if (Pos == 2 * HALF) {
+        Pos = 0;
+        filled(1);
+    }
+}
+
+/*********************************************************************
+ * @fn      drain
+ *
+ * @brief   Extends the captures stored since the last call to 32 bits.
+ *        Called from the TIM1 and DMA interrupts, which share one
+ *        priority, at least twice per timer period, so that no
+ *        capture is older than one period.
+ *
+ * @return  none
+ */
+static void drain(void)
+{
+    uint16_t pos = ECAP_RING - DMA1_Channel2->CNTR, c;
+    uint32_t now;
+
+    if (pos == ECAP_RING) pos = 0;
+    c = TIM1->CNT;                      /* Read after pos: every capture up to pos is older */
+    now = Epoch;
+    if ((TIM1->INTFR & TIM_UIF) && c < 0x8000) now++;  /* Overflow not counted yet */
+    now = (now << 16) | c;
+
+    if (TIM1->INTFR & TIM_CC1OF) {
+        TIM1->INTFR = (uint16_t)~TIM_CC1OF;
+        ECAP_Stat.Misses++;
+    }
+
+    while (Tail != pos) {
+        store(now - (uint16_t)(c - Ring[Tail]));
+        if (++Tail == ECAP_RING) Tail = 0;
+    }
+}
+
+/*********************************************************************
+ * @fn      ECAP_Init
+ *
+ * @brief   Initializes PD2, TIM1 channel 1 input capture with its DMA
+ *        request on DMA1 channel 2, and the TIM1 update, compare 4
+ *        and DMA interrupts. Capturing does not run until ECAP_Start
+ *        is called.
+ *
+ * @return  none
+ */
+void ECAP_Init(void)
+{
+    GPIO_InitTypeDef GPIO_InitStructure = {0};
+    TIM_TimeBaseInitTypeDef TIM_TimeBaseInitStructure = {0};
+    TIM_ICInitTypeDef TIM_ICInitStructure = {0};
+    DMA_InitTypeDef DMA_InitStructure = {0};
+    NVIC_InitTypeDef NVIC_InitStructure = {0};
+
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOD | RCC_APB2Periph_TIM1, ENABLE);
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+    GPIO_InitStructure.GPIO_Pin = GPIO_Pin_2;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IN_FLOATING;
+    GPIO_Init(GPIOD, &GPIO_InitStructure);
+
+    /* TIM1: free running over 16 bits, compare 4 at mid-period */
+    TIM_TimeBaseInitStructure.TIM_Period = 0xFFFF;
+    TIM_TimeBaseInitStructure.TIM_Prescaler = (uint16_t)(SystemCoreClock / ECAP_TICK_HZ - 1);
+    TIM_TimeBaseInitStructure.TIM_ClockDivision = TIM_CKD_DIV1;
+    TIM_TimeBaseInitStructure.TIM_CounterMode = TIM_CounterMode_Up;
+    TIM_TimeBaseInit(TIM1, &TIM_TimeBaseInitStructure);
+    TIM_SetCompare4(TIM1, 0x8000);
+
+    TIM_ICInitStructure.TIM_Channel = TIM_Channel_1;
+    TIM_ICInitStructure.TIM_ICPolarity = ECAP_POLARITY;
+    TIM_ICInitStructure.TIM_ICSelection = TIM_ICSelection_DirectTI;
+    TIM_ICInitStructure.TIM_ICPrescaler = TIM_ICPSC_DIV1;
+    TIM_ICInitStructure.TIM_ICFilter = ECAP_FILTER;
+    TIM_ICInit(TIM1, &TIM_ICInitStructure);
+    TIM_DMACmd(TIM1, TIM_DMA_CC1, ENABLE);
+
+    /* DMA1 channel 2: TIM1 CH1 capture, circular over the ring, interrupt at each half */
+    DMA_DeInit(DMA1_Channel2);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&TIM1->CH1CVR;
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)Ring;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_BufferSize = ECAP_RING;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_VeryHigh;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init(DMA1_Channel2, &DMA_InitStructure);
+    DMA_ITConfig(DMA1_Channel2, DMA_IT_HT | DMA_IT_TC, ENABLE);
+
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_InitStructure.NVIC_IRQChannel = TIM1_UP_IRQn;
+    NVIC_Init(&NVIC_InitStructure);
+    NVIC_InitStructure.NVIC_IRQChannel = TIM1_CC_IRQn;
+    NVIC_Init(&NVIC_InitStructure);
+    NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel2_IRQn;
+    NVIC_Init(&NVIC_InitStructure);
+}
+
+/*********************************************************************
+ * @fn      ECAP_Start
+ *
+ * @brief   Starts capturing, with the timestamps counted from 0. The
+ *        clock is held at CLKGOV_BUSY until ECAP_Stop.
+ *
+ * @return  none
+ */
+void ECAP_Start(void)
+{
+    CLKGOV_Set(CLKGOV_BUSY);            /* Before the prescaler is loaded */
+    Tail = 0;
+    Epoch = 0;
+    Pos = 0;
+    Full[0] = Full[1] = 0;
+    Next = 0;
+
+    DMA_Cmd(DMA1_Channel2, DISABLE);
+    DMA_SetCurrDataCounter(DMA1_Channel2, ECAP_RING);
+    DMA_Cmd(DMA1_Channel2, ENABLE);
+
+    ecap_timer();
+    TIM_GenerateEvent(TIM1, TIM_EventSource_Update);   /* Load PSC, zero CNT */
+    TIM1->INTFR = 0;
+    TIM_ITConfig(TIM1, TIM_IT_Update | TIM_IT_CC4, ENABLE);
+    TIM_Cmd(TIM1, ENABLE);
+}
+
+/*********************************************************************
+ * @fn      ECAP_Stop
+ *
+ * @brief   Stops capturing and leaves the clock at CLKGOV_IDLE. The
+ *        events captured so far are still written by ECAP_Flush.
+ *
+ * @return  none
+ */
+void ECAP_Stop(void)
+{
+    TIM_Cmd(TIM1, DISABLE);
+    TIM_ITConfig(TIM1, TIM_IT_Update | TIM_IT_CC4, DISABLE);
+    __disable_irq();
+    drain();
+    DMA_Cmd(DMA1_Channel2, DISABLE);
+    __enable_irq();
+    CLKGOV_Set(CLKGOV_IDLE);
+}
+
+/*********************************************************************
+ * @fn      ECAP_Poll
+ *
+ * @brief   Writes the filled halves to the file, one block each. The
+ *        file is synced every ECAP_SYNC_BLOCKS blocks. The clock is not
+ *        switched: ECAP_Start holds it at CLKGOV_BUSY.
+ *
+ * @param   fp - File opened for writing.
+ *
+ * @return  FR_OK, FR_DENIED on volume full, or the f_write/f_sync error.
+ */
+FRESULT ECAP_Poll(FIL *fp)
+{
+    FRESULT res = FR_OK;
+    UINT bw;
+
+    while (Full[Next]) {
+        res = f_write(fp, Out + Next * HALF, ECAP_BLOCK_SIZE, &bw);
+        if (res == FR_OK && bw != ECAP_BLOCK_SIZE) res = FR_DENIED;
+        if (res != FR_OK) break;
+
+        Full[Next] = 0;     /* Release the half only after it is on the card */
+        Next ^= 1;
+
+        if (++ECAP_Stat.Blocks % ECAP_SYNC_BLOCKS == 0) {
+            res = f_sync(fp);
+            if (res != FR_OK) break;
+        }
+    }
+
+    return res;
+}
+
+/*********************************************************************
+ * @fn      ECAP_Flush
+ *
+ * @brief   Writes every timestamp stored so far, including a partly
+ *        filled half, and syncs the file. Call it after ECAP_Stop.
+ *
+ * @param   fp - File opened for writing.
+ *
+ * @return  FR_OK, FR_DENIED on volume full, or the f_write/f_sync error.
+ */
+FRESULT ECAP_Flush(FIL *fp)
+{
+    FRESULT res = ECAP_Poll(fp);
+    UINT n, bw;
+
+    if (res == FR_OK && Pos > Next * HALF) {
+        n = (UINT)(Pos - Next * HALF) * 4;
+        res = f_write(fp, Out + Next * HALF, n, &bw);
+        if (res == FR_OK && bw != n) res = FR_DENIED;
+        if (res == FR_OK) Pos = Next * HALF;
+    }
+    if (res == FR_OK) res = f_sync(fp);
+
+    return res;
+}
+
+/*********************************************************************
+ * @fn      TIM1_UP_IRQHandler
+ *
+ * @brief   Counts the overflow and drains the captures.
+ *
+ * @return  none
+ */
+void TIM1_UP_IRQHandler(void)
+{
+    Epoch++;
+    TIM1->INTFR = (uint16_t)~TIM_UIF;
+    drain();
+}
+
+/*********************************************************************
+ * @fn      TIM1_CC_IRQHandler
+ *
+ * @brief   Mid-period drain on compare 4.
+ *
+ * @return  none
+ */
+void TIM1_CC_IRQHandler(void)
+{
+    TIM1->INTFR = (uint16_t)~TIM_CC4IF;
+    drain();
+}
+
+/*********************************************************************
+ * @fn      DMA1_Channel2_IRQHandler
+ *
+ * @brief   Drains the captures at each half of the ring.
+ *
+ * @return  none
+ */
+void DMA1_Channel2_IRQHandler(void)
+{
+    DMA1->INTFCR = DMA1->INTFR & (DMA1_IT_GL2 | DMA1_IT_TC2 | DMA1_IT_HT2 | DMA1_IT_TE2);
+    drain();
+}
+
+#endif /* ECAP_ENABLE */
@@ -0,0 +1,103 @@
+/*********************************************************************************
+ * File Name          : ecap.h
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Timer input capture event logger to SD card.
+ *********************************************************************************
+ * TIM1 channel 1 (PD2) captures the counter on every ECAP_POLARITY edge and
+ * DMA1 channel 2 moves the 16-bit captures into a small circular ring, so an
+ * edge is timestamped by hardware even while the CPU sits in disk_write.
+ *
+ * The captures are extended to 32 bits from interrupts: the TIM1 update
+ * interrupt counts the overflows, and the ring is drained at each update, at
+ * the compare at mid-period (TIM1 channel 4) and at each half of the ring.
+ * Draining at least twice per period keeps every capture younger than one
+ * timer period, so it is placed exactly by its distance to the counter:
+ *
+ *   t = now - (uint16_t)(CNT - capture)
+ *
+ * The timestamps go to a ring of two ECAP_BLOCK_SIZE halves (64 events each by
+ * default) that ECAP_Poll writes to the file. 256-byte halves are copied into
+ * the FatFs window (FF_FS_TINY), which reaches the card as a whole sector once
+ * the next half starts a new sector, so the ring takes 512 bytes of RAM rather
+ * than 1KB; 512-byte halves are written straight to the card. The file is a
+ * stream of little-endian 32-bit timestamps in ticks of ECAP_TICK_HZ, wrapping
+ * after 2^32 ticks (9 minutes at 8MHz). A half that is refilled before it was
+ * written is counted as an overrun, an edge lost because DMA did not read the
+ * capture register in time as a miss (overcapture).
+ *
+ * ECAP_TICK_HZ must divide SystemCoreClock. TIM1 loads a new prescaler only
+ * at its next update, up to one 16-bit period after a clock switch, so with
+ * CLKGOV ECAP_Start holds the clock at CLKGOV_BUSY until ECAP_Stop and nothing
+ * else may call CLKGOV_Set while capturing.
+ *******************************************************************************/
+#ifndef __ECAP_H
+#define __ECAP_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "debug.h"
+#include "ff.h"
+
+/* Event Capture Definition */
+#ifndef ECAP_ENABLE
+#define ECAP_ENABLE         0
+#endif
+
+#ifndef ECAP_TICK_HZ
+#define ECAP_TICK_HZ        8000000                 /* Timestamp resolution, 125ns */
+#endif
+
+#ifndef ECAP_POLARITY
+#define ECAP_POLARITY       TIM_ICPolarity_Rising   /* Or TIM_ICPolarity_Falling, TIM_ICPolarity_BothEdge */
+#endif
+
+#ifndef ECAP_FILTER
+#define ECAP_FILTER         0                       /* Input filter, TIM_ICFilter 0..15 */
+#endif
+
+#ifndef ECAP_RING
+#define ECAP_RING           32                      /* Captures in the DMA ring, drained every half */
+#endif
+
+#ifndef ECAP_BLOCK_SIZE
+#define ECAP_BLOCK_SIZE     256                     /* Bytes handed to the writer at a time, 256 or 512 */
+#endif
+
+#ifndef ECAP_SYNC_BLOCKS
+#define ECAP_SYNC_BLOCKS    (32768 / ECAP_BLOCK_SIZE)   /* f_sync interval in blocks (8192 events) */
+#endif
+
+#if (ECAP_RING < 4) || (ECAP_RING % 2)
+#error ECAP_RING must be even and at least 4
+#endif
+#if (ECAP_BLOCK_SIZE != 256) && (ECAP_BLOCK_SIZE != 512)
+#error ECAP_BLOCK_SIZE must be 256 or 512
+#endif
+
+/* Event capture statistics */
+typedef struct
+{
+    uint32_t Events;        /* Timestamps stored */
+    uint32_t Misses;        /* Overcaptures, edges lost between two DMA reads */
+    uint32_t Blocks;        /* Blocks written to the file */
+    uint32_t Overruns;      /* Blocks refilled before they were written */
+} ECAP_StatTypeDef;
+
+#if ECAP_ENABLE
+extern volatile ECAP_StatTypeDef ECAP_Stat;
+
+void    ECAP_Init(void);
+void    ECAP_Start(void);
+void    ECAP_Stop(void);
+FRESULT ECAP_Poll(FIL *fp);
+FRESULT ECAP_Flush(FIL *fp);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ECAP_H */
@@ -22,6 +22,7 @@
 #include <string.h>
 #include "ff.h"			/* Declarations of FatFs API */
 #include "diskio.h"		/* Declarations of device I/O functions */
+#include "perf.h"		/* Hot-path time measurement */
 
 
 /*--------------------------------------------------------------------------
@@ -266,6 +267,29 @@
 #endif
 
 
+/* Definitions of supported FAT sub-types */
+#if FF_FS_FATTYPES < 1 || FF_FS_FATTYPES > 7
+#error Wrong FF_FS_FATTYPES setting
+#endif
+#if !FF_FS_EXFAT && FF_FS_FATTYPES == 1
+#define FS_TYPE(fs)	FS_FAT12		/* Fixed FAT sub-type */
+#elif !FF_FS_EXFAT && FF_FS_FATTYPES == 2
+#define FS_TYPE(fs)	FS_FAT16		/* Fixed FAT sub-type */
+#elif !FF_FS_EXFAT && FF_FS_FATTYPES == 4
+#define FS_TYPE(fs)	FS_FAT32		/* Fixed FAT sub-type */
+#else
+#define FS_TYPE(fs)	((fs)->fs_type)	/* Variable FAT sub-type */
+#endif
+
+
+/* Write statistics */
+#if FF_USE_WSTAT
+#define WSTAT_ADD(fs, sect, n, data)	wstat_add(fs, sect, n, data)
+#else
+#define WSTAT_ADD(fs, sect, n, data)
+#endif
+
+
 /* Timestamp */
 #if FF_FS_NORTC == 1
 #if FF_NORTC_YEAR < 1980 || FF_NORTC_YEAR > 2107 || FF_NORTC_MON < 1 || FF_NORTC_MON > 12 || FF_NORTC_MDAY < 1 || FF_NORTC_MDAY > 31
@@ -1052,6 +1076,33 @@ static void clear_share (	/* Clear all lock entries of the volume */
 /* Move/Flush disk access window in the filesystem object                */
 /*-----------------------------------------------------------------------*/
 #if !FF_FS_READONLY
+#if FF_USE_WSTAT
+static void wstat_add (
+	FATFS* fs,		/* Filesystem object */
+	LBA_t sect,		/* Sector written */
+	UINT n,			/* Number of sectors written */
+	int data		/* Sectors in the data area hold file data (1) or directory (0) */
+)
+{
+	DWORD *c;
+
+
+	if (sect < fs->fatbase) {							/* Reserved area (VBR, FSInfo) */
+		c = &fs->wst.vol;
+	} else if (sect - fs->fatbase < fs->fsize) {		/* 1st FAT */
+		c = &fs->wst.fat;
+	} else if (sect - fs->fatbase < fs->fsize * fs->n_fats) {	/* 2nd FAT */
+		c = &fs->wst.fat2;
+	} else if (sect < fs->database || !data) {		/* Root directory (FAT12/16) or directory in the data area */
+		c = &fs->wst.dir;
+	} else {											/* File data */
+		c = &fs->wst.data;
+	}
+	*c += n;
+}
+#endif
+
+
 static FRESULT sync_window (	/* Returns FR_OK or FR_DISK_ERR */
 	FATFS* fs			/* Filesystem object */
 )
@@ -1062,13 +1113,21 @@ static FRESULT sync_window (	/* Returns FR_OK or FR_DISK_ERR */
 	if (fs->wflag) {	/* Is the disk access window dirty? */
 		if (disk_write(fs->pdrv, fs->win, fs->winsect, 1) == RES_OK) {	/* Write it back into the volume */
 			fs->wflag = 0;	/* Clear window dirty flag */
+			WSTAT_ADD(fs, fs->winsect, 1, fs->wdata);
 			if (fs->winsect - fs->fatbase < fs->fsize) {	/* Is it in the 1st FAT? */
-				if (fs->n_fats == 2) disk_write(fs->pdrv, fs->win, fs->winsect + fs->fsize, 1);	/* Reflect it to 2nd FAT if needed */
+				if (fs->n_fats == 2) {	/* Reflect it to 2nd FAT if needed */
+					if (disk_write(fs->pdrv, fs->win, fs->winsect + fs->fsize, 1) == RES_OK) {
+						WSTAT_ADD(fs, fs->winsect + fs->fsize, 1, 0);	/* Only a mirror that reached the card */
+					}
+				}
 			}
 		} else {
 			res = FR_DISK_ERR;
 		}
 	}
+#if FF_USE_WSTAT
+	fs->wdata = 0;	/* Window is clean, the next writer marks it again */
+#endif
 	return res;
 }
 #endif
@@ -1082,6 +1141,7 @@ static FRESULT move_window (	/* Returns FR_OK or FR_DISK_ERR */
 	FRESULT res = FR_OK;
 
 
+	PERF_BEGIN(PERF_MOVE_WINDOW);
 	if (sect != fs->winsect) {	/* Window offset changed? */
 #if !FF_FS_READONLY
 		res = sync_window(fs);		/* Flush the window */
@@ -1114,7 +1174,7 @@ static FRESULT sync_fs (	/* Returns FR_OK or FR_DISK_ERR */
 
 	res = sync_window(fs);
 	if (res == FR_OK) {
-		if (fs->fs_type == FS_FAT32 && fs->fsi_flag == 1) {	/* FAT32: Update FSInfo sector if needed */
+		if (FS_TYPE(fs) == FS_FAT32 && fs->fsi_flag == 1) {	/* FAT32: Update FSInfo sector if needed */
 			/* Create FSInfo structure */
 			memset(fs->win, 0, sizeof fs->win);
 			st_word(fs->win + BS_55AA, 0xAA55);					/* Boot signature */
@@ -1124,6 +1184,7 @@ static FRESULT sync_fs (	/* Returns FR_OK or FR_DISK_ERR */
 			st_dword(fs->win + FSI_Nxt_Free, fs->last_clst);	/* Last allocated culuster */
 			fs->winsect = fs->volbase + 1;						/* Write it into the FSInfo sector (Next to VBR) */
 			disk_write(fs->pdrv, fs->win, fs->winsect, 1);
+			WSTAT_ADD(fs, fs->winsect, 1, 0);
 			fs->fsi_flag = 0;
 		}
 		/* Make sure that no pending write process in the lower layer */
@@ -1163,18 +1224,22 @@ static DWORD get_fat (		/* 0xFFFFFFFF:Disk error, 1:Internal error, 2..0x7FFFFFF
 	DWORD clst		/* Cluster number to get the value */
 )
 {
+#if FF_FS_FATTYPES & 1
 	UINT wc, bc;
+#endif
 	DWORD val;
 	FATFS *fs = obj->fs;
 
 
+	PERF_BEGIN(PERF_GET_FAT);
 	if (clst < 2 || clst >= fs->n_fatent) {	/* Check if in valid range */
 		val = 1;	/* Internal error */
 
 	} else {
 		val = 0xFFFFFFFF;	/* Default value falls on disk error */
 
-		switch (fs->fs_type) {
+		switch (FS_TYPE(fs)) {
+#if FF_FS_FATTYPES & 1
 		case FS_FAT12 :
 			bc = (UINT)clst; bc += bc / 2;
 			if (move_window(fs, fs->fatbase + (bc / SS(fs))) != FR_OK) break;
@@ -1183,16 +1248,19 @@ static DWORD get_fat (		/* 0xFFFFFFFF:Disk error, 1:Internal error, 2..0x7FFFFFF
 			wc |= fs->win[bc % SS(fs)] << 8;	/* Merge 2nd byte of the entry */
 			val = (clst & 1) ? (wc >> 4) : (wc & 0xFFF);	/* Adjust bit position */
 			break;
-
+#endif
+#if FF_FS_FATTYPES & 2
 		case FS_FAT16 :
 			if (move_window(fs, fs->fatbase + (clst / (SS(fs) / 2))) != FR_OK) break;
 			val = ld_word(fs->win + clst * 2 % SS(fs));		/* Simple WORD array */
 			break;
-
+#endif
+#if FF_FS_FATTYPES & 4
 		case FS_FAT32 :
 			if (move_window(fs, fs->fatbase + (clst / (SS(fs) / 4))) != FR_OK) break;
 			val = ld_dword(fs->win + clst * 4 % SS(fs)) & 0x0FFFFFFF;	/* Simple DWORD array but mask out upper 4 bits */
 			break;
+#endif
 #if FF_FS_EXFAT
 		case FS_EXFAT :
 			if ((obj->objsize != 0 && obj->sclust != 0) || obj->stat == 0) {	/* Object except root dir must have valid data length */
@@ -1242,13 +1310,16 @@ static FRESULT put_fat (	/* FR_OK(0):succeeded, !=0:error */
 	DWORD val		/* New value to be set to the entry */
 )
 {
+#if FF_FS_FATTYPES & 1
 	UINT bc;
 	BYTE *p;
+#endif
 	FRESULT res = FR_INT_ERR;
 
 
 	if (clst >= 2 && clst < fs->n_fatent) {	/* Check if in valid range */
-		switch (fs->fs_type) {
+		switch (FS_TYPE(fs)) {
+#if FF_FS_FATTYPES & 1
 		case FS_FAT12:
 			bc = (UINT)clst; bc += bc / 2;	/* bc: byte offset of the entry */
 			res = move_window(fs, fs->fatbase + (bc / SS(fs)));
@@ -1262,15 +1333,19 @@ static FRESULT put_fat (	/* FR_OK(0):succeeded, !=0:error */
 			*p = (clst & 1) ? (BYTE)(val >> 4) : ((*p & 0xF0) | ((BYTE)(val >> 8) & 0x0F));	/* Update 2nd byte */
 			fs->wflag = 1;
 			break;
-
+#endif
+#if FF_FS_FATTYPES & 2
 		case FS_FAT16:
 			res = move_window(fs, fs->fatbase + (clst / (SS(fs) / 2)));
 			if (res != FR_OK) break;
 			st_word(fs->win + clst * 2 % SS(fs), (WORD)val);	/* Simple WORD array */
 			fs->wflag = 1;
 			break;
-
+#endif
+#if (FF_FS_FATTYPES & 4) || FF_FS_EXFAT
+#if FF_FS_FATTYPES & 4
 		case FS_FAT32:
+#endif
 #if FF_FS_EXFAT
 		case FS_EXFAT:
 #endif
@@ -1282,6 +1357,7 @@ static FRESULT put_fat (	/* FR_OK(0):succeeded, !=0:error */
 			st_dword(fs->win + clst * 4 % SS(fs), val);
 			fs->wflag = 1;
 			break;
+#endif
 		}
 	}
 	return res;
@@ -1531,6 +1607,7 @@ static DWORD create_chain (	/* 0:No free cluster, 1:Internal error, 0xFFFFFFFF:D
 	FATFS *fs = obj->fs;
 
 
+	PERF_BEGIN(PERF_CREATE_CHAIN);
 	if (clst == 0) {	/* Create a new chain */
 		scl = fs->last_clst;				/* Suggested cluster to start to find */
 		if (scl == 0 || scl >= fs->n_fatent) scl = 1;
@@ -1683,6 +1760,7 @@ static FRESULT dir_clear (	/* Returns FR_OK or FR_DISK_ERR */
 		ibuf = fs->win; szb = 1;	/* Use window buffer (many single-sector writes may take a time) */
 		for (n = 0; n < fs->csize && disk_write(fs->pdrv, ibuf, sect + n, szb) == RES_OK; n += szb) ;	/* Fill the cluster with 0 */
 	}
+	WSTAT_ADD(fs, sect, n, 0);
 	return (n == fs->csize) ? FR_OK : FR_DISK_ERR;
 }
 #endif	/* !FF_FS_READONLY */
@@ -1708,7 +1786,7 @@ static FRESULT dir_sdi (	/* FR_OK(0):succeeded, !=0:error */
 	}
 	dp->dptr = ofs;				/* Set current offset */
 	clst = dp->obj.sclust;		/* Table start cluster (0:root) */
-	if (clst == 0 && fs->fs_type >= FS_FAT32) {	/* Replace cluster# 0 with root cluster# */
+	if (clst == 0 && FS_TYPE(fs) >= FS_FAT32) {	/* Replace cluster# 0 with root cluster# */
 		clst = (DWORD)fs->dirbase;
 		if (FF_FS_EXFAT) dp->obj.stat = 0;	/* exFAT: Root dir has an FAT chain */
 	}
@@ -1853,7 +1931,7 @@ static DWORD ld_clust (	/* Returns the top cluster value of the SFN entry */
 	DWORD cl;
 
 	cl = ld_word(dir + DIR_FstClusLO);
-	if (fs->fs_type == FS_FAT32) {
+	if (FS_TYPE(fs) == FS_FAT32) {
 		cl |= (DWORD)ld_word(dir + DIR_FstClusHI) << 16;
 	}
 
@@ -1869,7 +1947,7 @@ static void st_clust (
 )
 {
 	st_word(dir + DIR_FstClusLO, (WORD)cl);
-	if (fs->fs_type == FS_FAT32) {
+	if (FS_TYPE(fs) == FS_FAT32) {
 		st_word(dir + DIR_FstClusHI, (WORD)(cl >> 16));
 	}
 }
@@ -2392,6 +2470,7 @@ static FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
 	BYTE a, ord, sum;
 #endif
 
+	PERF_BEGIN(PERF_DIR_FIND);
 	res = dir_sdi(dp, 0);			/* Rewind directory object */
 	if (res != FR_OK) return res;
 #if FF_FS_EXFAT
@@ -3541,6 +3620,7 @@ static FRESULT mount_volume (	/* FR_OK(0): successful, !=0: an error occurred */
 		if (nclst <= MAX_FAT16) fmt = FS_FAT16;
 		if (nclst <= MAX_FAT12) fmt = FS_FAT12;
 		if (fmt == 0) return FR_NO_FILESYSTEM;
+		if (!(FF_FS_FATTYPES & (1 << (fmt - 1)))) return FR_NO_FILESYSTEM;	/* (FAT sub-type is not supported in this configuration) */
 
 		/* Boundaries and Limits */
 		fs->n_fatent = nclst + 2;						/* Number of FAT entries */
@@ -3731,6 +3811,7 @@ FRESULT f_open (
 	DEF_NAMBUF
 
 
+	PERF_BEGIN(PERF_F_OPEN);
 	if (!fp) return FR_INVALID_OBJECT;
 
 	/* Get logical drive number */
@@ -3927,6 +4008,7 @@ FRESULT f_read (
 	BYTE *rbuff = (BYTE*)buff;
 
 
+	PERF_BEGIN(PERF_F_READ);
 	*br = 0;	/* Clear read byte counter */
 	res = validate(&fp->obj, &fs);				/* Check validity of the file object */
 	if (res != FR_OK || (res = (FRESULT)fp->err) != FR_OK) LEAVE_FF(fs, res);	/* Check validity */
@@ -3983,6 +4065,7 @@ FRESULT f_read (
 				if (fp->flag & FA_DIRTY) {		/* Write-back dirty sector cache */
 					if (disk_write(fs->pdrv, fp->buf, fp->sect, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);
 					fp->flag &= (BYTE)~FA_DIRTY;
+					WSTAT_ADD(fs, fp->sect, 1, 1);
 				}
 #endif
 				if (disk_read(fs->pdrv, fp->buf, sect, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);	/* Fill sector cache */
@@ -4026,6 +4109,7 @@ FRESULT f_write (
 	const BYTE *wbuff = (const BYTE*)buff;
 
 
+	PERF_BEGIN(PERF_F_WRITE);
 	*bw = 0;	/* Clear write byte counter */
 	res = validate(&fp->obj, &fs);			/* Check validity of the file object */
 	if (res != FR_OK || (res = (FRESULT)fp->err) != FR_OK) LEAVE_FF(fs, res);	/* Check validity */
@@ -4067,6 +4151,7 @@ FRESULT f_write (
 			if (fp->flag & FA_DIRTY) {		/* Write-back sector cache */
 				if (disk_write(fs->pdrv, fp->buf, fp->sect, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);
 				fp->flag &= (BYTE)~FA_DIRTY;
+				WSTAT_ADD(fs, fp->sect, 1, 1);
 			}
 #endif
 			sect = clst2sect(fs, fp->clust);	/* Get current sector */
@@ -4078,6 +4163,7 @@ FRESULT f_write (
 					cc = fs->csize - csect;
 				}
 				if (disk_write(fs->pdrv, wbuff, sect, cc) != RES_OK) ABORT(fs, FR_DISK_ERR);
+				WSTAT_ADD(fs, sect, cc, 1);
 #if FF_FS_MINIMIZE <= 2
 #if FF_FS_TINY
 				if (fs->winsect - sect < cc) {	/* Refill sector cache if it gets invalidated by the direct write */
@@ -4114,6 +4200,9 @@ FRESULT f_write (
 		if (move_window(fs, fp->sect) != FR_OK) ABORT(fs, FR_DISK_ERR);	/* Move sector window */
 		memcpy(fs->win + fp->fptr % SS(fs), wbuff, wcnt);	/* Fit data to the sector */
 		fs->wflag = 1;
+#if FF_USE_WSTAT
+		fs->wdata = 1;
+#endif
 #else
 		memcpy(fp->buf + fp->fptr % SS(fs), wbuff, wcnt);	/* Fit data to the sector */
 		fp->flag |= FA_DIRTY;
@@ -4121,6 +4210,9 @@ FRESULT f_write (
 	}
 
 	fp->flag |= FA_MODIFIED;				/* Set file change flag */
+#if FF_USE_WSTAT
+	fs->wst.ubytes += *bw;
+#endif
 
 	LEAVE_FF(fs, FR_OK);
 }
@@ -4142,6 +4234,7 @@ FRESULT f_sync (
 	BYTE *dir;
 
 
+	PERF_BEGIN(PERF_F_SYNC);
 	res = validate(&fp->obj, &fs);	/* Check validity of the file object */
 	if (res == FR_OK) {
 		if (fp->flag & FA_MODIFIED) {	/* Is there any change to the file? */
@@ -4149,6 +4242,7 @@ FRESULT f_sync (
 			if (fp->flag & FA_DIRTY) {	/* Write-back cached data if needed */
 				if (disk_write(fs->pdrv, fp->buf, fp->sect, 1) != RES_OK) LEAVE_FF(fs, FR_DISK_ERR);
 				fp->flag &= (BYTE)~FA_DIRTY;
+				WSTAT_ADD(fs, fp->sect, 1, 1);
 			}
 #endif
 			/* Update the directory entry */
@@ -4446,6 +4540,7 @@ FRESULT f_lseek (
 	LBA_t dsc;
 #endif
 
+	PERF_BEGIN(PERF_F_LSEEK);
 	res = validate(&fp->obj, &fs);		/* Check validity of the file object */
 	if (res == FR_OK) res = (FRESULT)fp->err;
 #if FF_FS_EXFAT && !FF_FS_READONLY
@@ -4496,6 +4591,7 @@ FRESULT f_lseek (
 					if (fp->flag & FA_DIRTY) {		/* Write-back dirty sector cache */
 						if (disk_write(fs->pdrv, fp->buf, fp->sect, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);
 						fp->flag &= (BYTE)~FA_DIRTY;
+						WSTAT_ADD(fs, fp->sect, 1, 1);
 					}
 #endif
 					if (disk_read(fs->pdrv, fp->buf, dsc, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);	/* Load current sector */
@@ -4576,6 +4672,7 @@ FRESULT f_lseek (
 			if (fp->flag & FA_DIRTY) {			/* Write-back dirty sector cache */
 				if (disk_write(fs->pdrv, fp->buf, fp->sect, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);
 				fp->flag &= (BYTE)~FA_DIRTY;
+				WSTAT_ADD(fs, fp->sect, 1, 1);
 			}
 #endif
 			if (disk_read(fs->pdrv, fp->buf, nsect, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);	/* Fill sector cache */
@@ -4837,7 +4934,7 @@ FRESULT f_getfree (
 		} else {
 			/* Scan FAT to obtain number of free clusters */
 			nfree = 0;
-			if (fs->fs_type == FS_FAT12) {	/* FAT12: Scan bit field FAT entries */
+			if (FS_TYPE(fs) == FS_FAT12) {	/* FAT12: Scan bit field FAT entries */
 				clst = 2; obj.fs = fs;
 				do {
 					stat = get_fat(&obj, clst);
@@ -4880,7 +4977,7 @@ FRESULT f_getfree (
 							res = move_window(fs, sect++);
 							if (res != FR_OK) break;
 						}
-						if (fs->fs_type == FS_FAT16) {
+						if (FS_TYPE(fs) == FS_FAT16) {
 							if (ld_word(fs->win + i) == 0) nfree++;
 							i += 2;
 						} else {
@@ -4943,6 +5040,7 @@ FRESULT f_truncate (
 				res = FR_DISK_ERR;
 			} else {
 				fp->flag &= (BYTE)~FA_DIRTY;
+				WSTAT_ADD(fs, fp->sect, 1, 1);
 			}
 		}
 #endif
@@ -5705,6 +5803,7 @@ FRESULT f_forward (
 			if (fp->flag & FA_DIRTY) {		/* Write-back dirty sector cache */
 				if (disk_write(fs->pdrv, fp->buf, fp->sect, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);
 				fp->flag &= (BYTE)~FA_DIRTY;
+				WSTAT_ADD(fs, fp->sect, 1, 1);
 			}
 #endif
 			if (disk_read(fs->pdrv, fp->buf, sect, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);
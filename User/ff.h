@@ -127,6 +127,20 @@ extern const char* VolumeStr[FF_VOLUMES];	/* User defied volume ID */
 
 
 
+/* Write statistics structure (FATFS.wst) */
+
+#if FF_USE_WSTAT
+typedef struct {
+	DWORD	ubytes;			/* Bytes written by f_write() */
+	DWORD	vol;			/* Sectors written in the reserved area (VBR, FSInfo) */
+	DWORD	fat;			/* Sectors written in the 1st FAT */
+	DWORD	fat2;			/* Sectors written in the 2nd FAT (mirror) */
+	DWORD	dir;			/* Sectors written in the directories (and exFAT bitmap) */
+	DWORD	data;			/* Sectors written in the file data */
+} FF_WSTAT;
+#endif
+
+
 /* Filesystem object structure (FATFS) */
 
 typedef struct {
@@ -170,6 +184,10 @@ typedef struct {
 	LBA_t	bitbase;		/* Allocation bitmap base sector */
 #endif
 	LBA_t	winsect;		/* Current sector appearing in the win[] */
+#if FF_USE_WSTAT
+	BYTE	wdata;			/* win[] was made dirty by file data (tiny cfg) */
+	FF_WSTAT	wst;		/* Write statistics */
+#endif
 	BYTE	win[FF_MAX_SS];	/* Disk access window for Directory, FAT (and file data at tiny cfg) */
 } FATFS;
 
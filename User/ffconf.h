@@ -30,16 +30,22 @@
 /  f_findnext(). (0:Disable, 1:Enable 2:Enable with matching altname[] too) */
 
 
+#ifndef FF_USE_MKFS
 #define FF_USE_MKFS		0
-/* This option switches f_mkfs() function. (0:Disable or 1:Enable) */
+#endif
+/* This option switches f_mkfs() function. (0:Disable or 1:Enable)
+/  The firmware does not format; Host/Makefile enables it for the host tools. */
 
 
 #define FF_USE_FASTSEEK	0
 /* This option switches fast seek function. (0:Disable or 1:Enable) */
 
 
+#ifndef FF_USE_EXPAND
 #define FF_USE_EXPAND	0
-/* This option switches f_expand function. (0:Disable or 1:Enable) */
+#endif
+/* This option switches f_expand function. (0:Disable or 1:Enable)
+/  Only Host/ffprep preallocates; Host/Makefile enables it for the host tools. */
 
 
 #define FF_USE_CHMOD	0
@@ -56,6 +62,14 @@
 /* This option switches f_forward() function. (0:Disable or 1:Enable) */
 
 
+#define FF_USE_WSTAT	0
+/* This option switches write statistics in the filesystem object, FATFS.wst.
+/  (0:Disable or 1:Enable) Every sector written to the volume is counted in the
+/  region it falls in, and the bytes given to f_write() are counted as well,
+/  so that (vol + fat + fat2 + dir + data) * sector size / ubytes is the write
+/  amplification of the application. Clear FATFS.wst to restart counting. */
+
+
 #define FF_USE_STRFUNC	0
 #define FF_PRINT_LLI	1
 #define FF_PRINT_FLOAT	1
@@ -224,7 +238,7 @@
 / System Configurations
 /---------------------------------------------------------------------------*/
 
-#define FF_FS_TINY		0
+#define FF_FS_TINY		1
 /* This option switches tiny buffer configuration. (0:Normal or 1:Tiny)
 /  At the tiny configuration, size of file object (FIL) is shrinked FF_MAX_SS bytes.
 /  Instead of private sector buffer eliminated from the file object, common sector
@@ -237,6 +251,20 @@
 /  Note that enabling exFAT discards ANSI C (C89) compatibility. */
 
 
+#define FF_FS_FATTYPES	4
+/* This option specifies the FAT sub-types to be supported in bit flags. A volume
+/  of a removed sub-type fails to mount with FR_NO_FILESYSTEM and the FAT access
+/  code for it is eliminated. When only one sub-type is specified and exFAT is
+/  disabled, the sub-type is fixed at compile time and FAT entry accesses in
+/  get_fat() and put_fat() are done without the run-time sub-type dispatch.
+/
+/   bit0=1: FAT12 is supported.
+/   bit1=1: FAT16 is supported.
+/   bit2=1: FAT32 is supported.
+/
+/  Set 7 to support all FAT sub-types. f_mkfs() is not affected by this option. */
+
+
 #define FF_FS_NORTC		0
 #define FF_NORTC_MON	1
 #define FF_NORTC_MDAY	1
@@ -275,7 +303,9 @@
 /      lock control is independent of re-entrancy. */
 
 
+#ifndef FF_FS_REENTRANT
 #define FF_FS_REENTRANT	0
+#endif
 #define FF_FS_TIMEOUT	1000
 /* The option FF_FS_REENTRANT switches the re-entrancy (thread safe) of the FatFs
 /  module itself. Note that regardless of this option, file access to different
@@ -288,7 +318,12 @@
 /      ff_mutex_create(), ff_mutex_delete(), ff_mutex_take() and ff_mutex_give()
 /      function, must be added to the project. Samples are available in ffsystem.c.
 /
-/  The FF_FS_TIMEOUT defines timeout period in unit of O/S time tick.
+/  The FF_FS_TIMEOUT defines timeout period in unit of O/S time tick. With the
+/  cooperative scheduler in sched.c (OS_TYPE 5 in ffsystem.c), a taken mutex can
+/  never be released while waiting, so FF_FS_TIMEOUT has no effect and a
+/  conflicting access fails with FR_TIMEOUT immediately.
+/
+/  Define it to 1 in the build for PFAIL_ENABLE and for APP_ADC_LOG (main.c).
 */
 
 
@@ -39,7 +39,7 @@ void ff_memfree (
 /* Definitions of Mutex                                                   */
 /*------------------------------------------------------------------------*/
 
-#define OS_TYPE	0	/* 0:Win32, 1:uITRON4.0, 2:uC/OS-II, 3:FreeRTOS, 4:CMSIS-RTOS */
+#define OS_TYPE	5	/* 0:Win32, 1:uITRON4.0, 2:uC/OS-II, 3:FreeRTOS, 4:CMSIS-RTOS, 5:sched.c */
 
 
 #if   OS_TYPE == 0	/* Win32 */
@@ -64,6 +64,11 @@ static SemaphoreHandle_t Mutex[FF_VOLUMES + 1];	/* Table of mutex handle */
 #include "cmsis_os.h"
 static osMutexId Mutex[FF_VOLUMES + 1];	/* Table of mutex ID */
 
+#elif OS_TYPE == 5	/* Cooperative scheduler */
+#include "sched.h"
+#include "pfail.h"
+static sched_mutex_t Mutex[FF_VOLUMES + 1];	/* Table of mutex flag */
+
 #endif
 
 
@@ -106,6 +111,10 @@ int ff_mutex_create (	/* Returns 1:Function succeeded or 0:Could not create the
 	Mutex[vol] = osMutexCreate(osMutex(cmsis_os_mutex));
 	return (int)(Mutex[vol] != NULL);
 
+#elif OS_TYPE == 5	/* Cooperative scheduler */
+	sched_mutex_unlock(&Mutex[vol]);
+	return 1;
+
 #endif
 }
 
@@ -138,6 +147,9 @@ void ff_mutex_delete (	/* Returns 1:Function succeeded or 0:Could not delete due
 #elif OS_TYPE == 4	/* CMSIS-RTOS */
 	osMutexDelete(Mutex[vol]);
 
+#elif OS_TYPE == 5	/* Cooperative scheduler */
+	sched_mutex_unlock(&Mutex[vol]);
+
 #endif
 }
 
@@ -171,6 +183,11 @@ int ff_mutex_take (	/* Returns 1:Succeeded or 0:Timeout */
 #elif OS_TYPE == 4	/* CMSIS-RTOS */
 	return (int)(osMutexWait(Mutex[vol], FF_FS_TIMEOUT) == osOK);
 
+#elif OS_TYPE == 5	/* Cooperative scheduler */
+	/* A taken mutex is owned by a task further down the same stack (a nested
+	   task called from sched_yield), so waiting for it would never end */
+	return sched_mutex_trylock(&Mutex[vol]);
+
 #endif
 }
 
@@ -201,8 +218,30 @@ void ff_mutex_give (
 #elif OS_TYPE == 4	/* CMSIS-RTOS */
 	osMutexRelease(Mutex[vol]);
 
+#elif OS_TYPE == 5	/* Cooperative scheduler */
+	sched_mutex_unlock(&Mutex[vol]);
+	PFAIL_Leave(vol);	/* Run a power-fail flush held back while the volume was busy */
+
 #endif
 }
 
+
+
+#if OS_TYPE == 5
+/*------------------------------------------------------------------------*/
+/* Check a Mutex                                                          */
+/*------------------------------------------------------------------------*/
+/* This function is called from an interrupt (pfail.c) to find out whether
+/  a FatFs function is running on the volume it has preempted.
+*/
+
+int ff_mutex_held (	/* Returns 1:Taken or 0:Free */
+	int vol			/* Mutex ID: Volume mutex (0 to FF_VOLUMES - 1) or system mutex (FF_VOLUMES) */
+)
+{
+	return (int)(Mutex[vol] != 0);
+}
+#endif
+
 #endif	/* FF_FS_REENTRANT */
 
@@ -0,0 +1,238 @@
+/*********************************************************************************
+ * File Name          : fwup.c
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Firmware update from the SD card.
+ *******************************************************************************/
+#include <string.h>
+#include "fwup.h"
+#include "diskio.h"
+#include "crc32.h"
+
+#if FWUP_ENABLE
+
+/* FLASH_CTLR bits and keys, private to ch32v00x_flash.c */
+#define CTLR_STRT           0x00000040
+#define CTLR_LOCK           0x00000080
+#define CTLR_FLOCK          0x00008000
+#define CTLR_PAGE_PG        0x00010000
+#define CTLR_PAGE_ER        0x00020000
+#define CTLR_BUF_LOAD       0x00040000
+#define CTLR_BUF_RST        0x00080000
+#define KEY1                0x45670123
+#define KEY2                0xCDEF89AB
+
+#define STEPS               19                  /* Flash operations per page: erase, reset, 16 loads, program */
+#define TOKEN_TRIES         100000              /* Data token wait, about 100ms at SCLK_FAST */
+
+/* Code run from the start of RAM, copied there by FWUP_Run (Ld/Link.ld) */
+#define FWUP_CODE           __attribute__((section(".fwup"), noinline))
+
+/* CMD18 stream of the image */
+typedef struct
+{
+    uint32_t Sect;                      /* First sector of the image */
+    uint32_t Pos;                       /* Image offset of the next byte */
+    uint16_t Left;                      /* Bytes left in the current block, 0: data token next */
+    uint8_t  Block;                     /* CT_BLOCK: sector addressing */
+    uint8_t  Tries;                     /* Stream restarts */
+} FWUP_StreamTypeDef;
+
+extern uint8_t _kv_start[];             /* End of the application region, Ld/Link.ld */
+extern uint8_t _fwup_vma[], _efwup[], _fwup_lma[];
+
+/*
+ * Nothing in flash may run once the first page is erased. The helpers below
+ * are inlined into program(), which never returns: its prologue, the only
+ * place that may call into flash (-msave-restore), runs before. xchg() is
+ * the one call, a leaf that saves no register and so has no such prologue.
+ */
+
+static FWUP_CODE uint8_t xchg(uint8_t d)
+{
+    return SPI_Xchg_Fast(SPI1, d);
+}
+
+__attribute__((always_inline)) static inline void command(uint8_t cmd, uint32_t arg)
+{
+    uint8_t n;
+
+    xchg(0x40 | cmd);
+    for (n = 32; n; ) {
+        n -= 8;
+        xchg((uint8_t)(arg >> n));
+    }
+    xchg(0x01);                         /* Dummy CRC + Stop */
+    if (cmd == CMD12) xchg(0xFF);       /* Stuff byte */
+    for (n = 10; (xchg(0xFF) & 0x80) && --n; );
+}
+
+/* Stops the stream and starts a new CMD18 at the sector holding s->Pos */
+__attribute__((always_inline)) static inline void seek(FWUP_StreamTypeDef *s)
+{
+    uint32_t a = s->Sect + s->Pos / 512, n;
+
+    command(CMD12, 0);
+    for (n = TOKEN_TRIES; xchg(0xFF) != 0xFF && --n; );  /* Busy after the stop */
+    command(CMD18, s->Block ? a : a * 512);
+}
+
+/*
+ * Next byte of the image. A data token that does not come in time restarts
+ * the stream where it stopped; after FWUP_RETRIES restarts the chip resets
+ * into the system bootloader instead of the partly programmed image.
+ */
+__attribute__((always_inline)) static inline uint8_t rx(FWUP_StreamTypeDef *s)
+{
+    uint32_t n;
+    uint8_t d;
+
+    while (s->Left == 0) {
+        n = TOKEN_TRIES;
+        do d = xchg(0xFF); while (d == 0xFF && --n);
+        if (d == 0xFE) {
+            s->Left = 512 - s->Pos % 512;
+            for (n = s->Pos % 512; n; n--) xchg(0xFF);  /* Up to Pos after a restart */
+            break;
+        }
+        if (++s->Tries > FWUP_RETRIES) {
+            FLASH->BOOT_MODEKEYR = KEY1;
+            FLASH->BOOT_MODEKEYR = KEY2;
+            FLASH->STATR |= 1 << 14;    /* Start_Mode_BOOT */
+            FLASH->CTLR |= CTLR_FLOCK | CTLR_LOCK;
+            NVIC_SystemReset();
+            while (1);
+        }
+        seek(s);
+    }
+    d = xchg(0xFF);
+    s->Pos++;
+    if (--s->Left == 0) {
+        xchg(0xFF);                     /* CRC */
+        xchg(0xFF);
+    }
+    return d;
+}
+
+/*
+ * Programs page n - 1 from cur while page n is received into next. Each
+ * step starts one flash operation and receives while the flash is busy,
+ * the last one receives the rest of the page.
+ */
+static FWUP_CODE __attribute__((noreturn)) void program(uint32_t pages, FWUP_StreamTypeDef *s, uint8_t *cur, uint8_t *next)
+{
+    uint32_t addr = FLASH_BASE, n;
+    uint8_t got, i, *t;
+
+    FLASH->KEYR = KEY1;
+    FLASH->KEYR = KEY2;
+    FLASH->MODEKEYR = KEY1;
+    FLASH->MODEKEYR = KEY2;
+
+    for (n = 0; n <= pages; n++) {
+        got = (n < pages) ? 0 : FWUP_PAGE_SIZE;     /* Nothing to receive after the last page */
+        for (i = n ? 0 : STEPS; i <= STEPS; i++) {
+            if (i < STEPS) {
+                FLASH->CTLR |= i ? CTLR_PAGE_PG : CTLR_PAGE_ER;
+                if (i == 0 || i == STEPS - 1) {     /* FLASH_ErasePage_Fast, FLASH_ProgramPage_Fast */
+                    FLASH->ADDR = addr;
+                    FLASH->CTLR |= CTLR_STRT;
+                } else if (i == 1) {                /* FLASH_BufReset */
+                    FLASH->CTLR |= CTLR_BUF_RST;
+                } else {                            /* FLASH_BufLoad */
+                    *(__IO uint32_t *)(addr + 4 * (i - 2)) = ((const uint32_t *)cur)[i - 2];
+                    FLASH->CTLR |= CTLR_BUF_LOAD;
+                }
+            }
+            while ((FLASH->STATR & FLASH_STATR_BSY) || (i == STEPS && got < FWUP_PAGE_SIZE)) {
+                if (got < FWUP_PAGE_SIZE) next[got++] = rx(s);
+            }
+            FLASH->CTLR &= ~(CTLR_PAGE_ER | CTLR_PAGE_PG);
+        }
+        t = cur;
+        cur = next;
+        next = t;
+        if (n) addr += FWUP_PAGE_SIZE;
+    }
+
+    FLASH->CTLR |= CTLR_FLOCK | CTLR_LOCK;
+    NVIC_SystemReset();
+    while (1);
+}
+
+/*********************************************************************
+ * @fn      FWUP_Run
+ *
+ * @brief   Installs FWUP_FILE when it holds an image other than the
+ *        running one. Does not return once the flash is reprogrammed.
+ *        Call it after f_mount, before any interrupt driven module is
+ *        started.
+ *
+ * @return  FWUP_NONE, FWUP_EIMAGE, FWUP_EFRAG or FWUP_EDISK
+ */
+uint8_t FWUP_Run(void)
+{
+    FIL fil;
+    FATFS *fs;
+    UINT br;
+    LBA_t sect;
+    FWUP_StreamTypeDef s = {0};
+    uint32_t len, crc, trailer[2], buf[2][FWUP_PAGE_SIZE / 4];
+    DWORD csize;
+    BYTE type;
+
+    if (f_open(&fil, FWUP_FILE, FA_READ) != FR_OK) return FWUP_NONE;
+    fs = fil.obj.fs;
+    csize = (DWORD)fs->csize * FF_MAX_SS;
+
+    len = (uint32_t)f_size(&fil) - sizeof trailer;
+    if (f_size(&fil) < sizeof trailer + FWUP_PAGE_SIZE || len > (uint32_t)_kv_start || len % FWUP_PAGE_SIZE) {
+        f_close(&fil);
+        return FWUP_EIMAGE;
+    }
+    if (f_lseek(&fil, len) != FR_OK || f_read(&fil, trailer, sizeof trailer, &br) != FR_OK || br != sizeof trailer) {
+        f_close(&fil);
+        return FWUP_EDISK;
+    }
+    if (trailer[1] != FWUP_MAGIC) {
+        f_close(&fil);
+        return FWUP_EIMAGE;
+    }
+    if (CRC32_Update(0, (const void *)FLASH_BASE, len) == trailer[0]) {
+        f_close(&fil);
+        return FWUP_NONE;               /* Installed already */
+    }
+
+    /* Whole image: CRC, and each cluster must follow the previous one */
+    crc = 0;
+    f_lseek(&fil, 0);
+    while (fil.fptr < len) {
+        if (f_read(&fil, buf[0], FWUP_PAGE_SIZE, &br) != FR_OK || br != FWUP_PAGE_SIZE) {
+            f_close(&fil);
+            return FWUP_EDISK;
+        }
+        crc = CRC32_Update(crc, buf[0], FWUP_PAGE_SIZE);
+        if (fil.clust != fil.obj.sclust + (fil.fptr - 1) / csize) {
+            f_close(&fil);
+            return FWUP_EFRAG;
+        }
+    }
+    sect = fs->database + (LBA_t)fs->csize * (fil.obj.sclust - 2);
+    f_close(&fil);
+    if (crc != trailer[0]) return FWUP_EIMAGE;
+
+    printf("FWUP:%u bytes\r\n", (unsigned)len);
+    USART_Printf_Flush();
+    if (disk_ioctl(fs->pdrv, MMC_GET_TYPE, &type) != RES_OK ||
+        disk_ioctl(fs->pdrv, MMC_READ_STREAM, &sect) != RES_OK) return FWUP_EDISK;
+    /* The stream keeps the card claimed (disk_busy), program() ends in a reset */
+    s.Sect = (uint32_t)sect;
+    s.Block = type & CT_BLOCK;
+
+    SystemReset_StartMode(Start_Mode_USER);
+    __disable_irq();
+    memcpy(_fwup_vma, _fwup_lma, _efwup - _fwup_vma);
+    program(len / FWUP_PAGE_SIZE, &s, (uint8_t *)buf[0], (uint8_t *)buf[1]);
+}
+
+#endif /* FWUP_ENABLE */
@@ -0,0 +1,73 @@
+/*********************************************************************************
+ * File Name          : fwup.h
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Firmware update from the SD card.
+ *********************************************************************************
+ * FWUP_Run looks for FWUP_FILE on the mounted volume, an image made by
+ * Host/fwpack.py: the application binary padded to 64 bytes, followed by
+ *
+ *   crc32(4) "FWUP"(4)
+ *
+ * Nothing happens when the file is missing or the flash already holds this
+ * image (same CRC-32). Otherwise the whole file is read and checked through
+ * FatFs first, and it must be contiguous on the card. Only then is the flash
+ * reprogrammed, which cannot be undone: interrupts are disabled and a loop
+ * in RAM reads the file with a multiple block read (CMD18), erases and
+ * programs each 64-byte page with the fast page operations, and receives the
+ * next page from the card while the flash is busy with the current one, so
+ * the card adds nothing to the flash erase and program times. The loop ends
+ * with a system reset into the new image (Start_Mode_USER). It is linked in
+ * the .fwup section, which takes no RAM until FWUP_Run copies it over the
+ * start of RAM, below the stack (Ld/Link.ld).
+ *
+ * A data token that does not come within about 100ms restarts the CMD18 at
+ * the byte the loop stopped at. After FWUP_RETRIES restarts the chip resets
+ * into the system bootloader (Start_Mode_BOOT), as the flash holds no whole
+ * application then; after a power loss in the loop it is recovered with
+ * WCH-Link.
+ *
+ * The KV store region at the top of the flash (Ld/Link.ld) is kept; the new
+ * image must be linked with the same __kv_size.
+ *******************************************************************************/
+#ifndef __FWUP_H
+#define __FWUP_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "debug.h"
+#include "ff.h"
+
+/* Firmware Update Definition */
+#ifndef FWUP_ENABLE
+#define FWUP_ENABLE         0
+#endif
+
+#ifndef FWUP_FILE
+#define FWUP_FILE           "FIRMWARE.UPD"          /* Host/fwpack.py output */
+#endif
+
+#ifndef FWUP_RETRIES
+#define FWUP_RETRIES        16                      /* CMD18 restarts before giving up */
+#endif
+
+#define FWUP_PAGE_SIZE      64                      /* Fast program page */
+#define FWUP_MAGIC          0x50555746              /* "FWUP" read as little-endian */
+
+/* FWUP_Run results, it does not return after a successful update */
+#define FWUP_NONE           0                       /* No file, or the image is already installed */
+#define FWUP_EIMAGE         1                       /* Bad size, trailer or CRC */
+#define FWUP_EFRAG          2                       /* File not contiguous on the card */
+#define FWUP_EDISK          3                       /* FatFs or card error */
+
+#if FWUP_ENABLE
+uint8_t FWUP_Run(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FWUP_H */
@@ -0,0 +1,333 @@
+/*********************************************************************************
+ * File Name          : i2cq.c
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Interrupt and DMA driven I2C1 master transaction queue.
+ *******************************************************************************/
+#include "i2cq.h"
+#include "clkgov.h"
+
+#if I2CQ_ENABLE
+
+void I2C1_EV_IRQHandler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
+void I2C1_ER_IRQHandler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
+void DMA1_Channel7_IRQHandler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
+
+#define SCL_PIN         GPIO_Pin_2
+#define SDA_PIN         GPIO_Pin_1
+
+#define STAR1_ERRORS    (I2C_STAR1_BERR | I2C_STAR1_ARLO | I2C_STAR1_AF | I2C_STAR1_OVR)
+
+volatile I2CQ_StatTypeDef I2CQ_Stat;
+
+static I2CQ_XferTypeDef *Queue[I2CQ_DEPTH];
+static uint8_t QHead, QTail;            /* Transactions submitted / finished */
+static I2CQ_XferTypeDef *Cur;           /* Running transaction, 0 when idle */
+static uint8_t Reading;                 /* Cur is in its read phase */
+static volatile uint16_t Timer;         /* ms left for Cur */
+static volatile uint8_t Abort;          /* Status to end Cur with from the error interrupt */
+
+/* I2C1 at I2CQ_SPEED for the current PCLK, interrupts and DMA requests on */
+static void setup(void)
+{
+    I2C_InitTypeDef I2C_InitStructure = {0};
+
+    I2C_InitStructure.I2C_ClockSpeed = I2CQ_SPEED;
+    I2C_InitStructure.I2C_Mode = I2C_Mode_I2C;
+    I2C_InitStructure.I2C_DutyCycle = I2C_DutyCycle_2;
+    I2C_InitStructure.I2C_OwnAddress1 = 0;
+    I2C_InitStructure.I2C_Ack = I2C_Ack_Enable;
+    I2C_InitStructure.I2C_AcknowledgedAddress = I2C_AcknowledgedAddress_7bit;
+    I2C_Init(I2C1, &I2C_InitStructure);
+    I2C1->CTLR2 |= I2C_CTLR2_ITEVTEN | I2C_CTLR2_ITERREN | I2C_CTLR2_DMAEN;
+}
+
+static void pins(GPIOMode_TypeDef mode)
+{
+    GPIO_InitTypeDef GPIO_InitStructure = {0};
+
+    GPIO_InitStructure.GPIO_Pin = SCL_PIN | SDA_PIN;
+    GPIO_InitStructure.GPIO_Mode = mode;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+    GPIO_Init(GPIOC, &GPIO_InitStructure);
+}
+
+/* Reset I2C1, clocking out a slave stuck in a read first */
+static void recover(void)
+{
+    uint8_t i;
+
+    DMA1_Channel6->CFGR &= ~DMA_CFGR1_EN;
+    DMA1_Channel7->CFGR &= ~DMA_CFGR1_EN;
+    I2C1->CTLR1 = I2C_CTLR1_SWRST;
+    I2C1->CTLR1 = 0;
+    I2CQ_Stat.Recoveries++;
+
+    if ((GPIOC->INDR & SDA_PIN) == 0) {
+        GPIOC->BSHR = SCL_PIN | SDA_PIN;
+        pins(GPIO_Mode_Out_OD);
+        for (i = 0; i < 9 && (GPIOC->INDR & SDA_PIN) == 0; i++) {
+            GPIOC->BCR = SCL_PIN;
+            Delay_Us(5);
+            GPIOC->BSHR = SCL_PIN;
+            Delay_Us(5);
+        }
+        GPIOC->BCR = SDA_PIN;               /* STOP: SDA rises while SCL is high */
+        Delay_Us(5);
+        GPIOC->BSHR = SDA_PIN;
+        Delay_Us(5);
+        pins(GPIO_Mode_AF_OD);
+        I2CQ_Stat.BusClears++;
+    }
+    setup();
+}
+
+static void dma_start(DMA_Channel_TypeDef *ch, const uint8_t *buf, uint16_t len)
+{
+    ch->CFGR &= ~DMA_CFGR1_EN;
+    ch->MADDR = (uint32_t)buf;
+    ch->CNTR = len;
+    ch->CFGR |= DMA_CFGR1_EN;
+}
+
+/* Start the next queued transaction, called with the I2C interrupts masked */
+static void start_next(void)
+{
+    uint8_t n = 100;
+
+    if (QTail == QHead) {
+        Cur = 0;
+        return;
+    }
+    Cur = Queue[QTail % I2CQ_DEPTH];
+    Reading = (Cur->WrLen == 0);
+    Timer = I2CQ_TIMEOUT_MS;
+    while ((I2C1->CTLR1 & I2C_CTLR1_STOP) && --n) Delay_Us(1);     /* Previous STOP still on the bus */
+    I2C1->CTLR1 |= I2C_CTLR1_START | I2C_CTLR1_ACK;
+}
+
+static void finish(uint8_t status)
+{
+    DMA1_Channel6->CFGR &= ~DMA_CFGR1_EN;
+    DMA1_Channel7->CFGR &= ~DMA_CFGR1_EN;
+    I2C1->CTLR2 &= ~I2C_CTLR2_LAST;
+    Timer = 0;
+    Abort = 0;
+
+    switch (status) {
+    case I2CQ_DONE:     I2CQ_Stat.Xfers++; break;
+    case I2CQ_NACK:     I2CQ_Stat.Nacks++; break;
+    case I2CQ_BUSERR:   I2CQ_Stat.BusErrors++; break;
+    default:            I2CQ_Stat.Timeouts++; break;
+    }
+    Cur->Status = status;
+    QTail++;
+    start_next();
+}
+
+#if CLKGOV_ENABLE
+/* PE must be off to change the SCL dividers, a transaction in flight is lost */
+static void i2c_clock(uint32_t old_hz, uint32_t new_hz)
+{
+    setup();
+    if (Cur) {
+        Abort = I2CQ_TIMEOUT;
+        NVIC_SetPendingIRQ(I2C1_ER_IRQn);
+    }
+}
+#endif
+
+/*********************************************************************
+ * @fn      I2CQ_Init
+ *
+ * @brief   Initializes PC1/PC2, I2C1, DMA1 channels 6 and 7 and the
+ *        interrupts. The event, error and DMA interrupts share one
+ *        preemption priority so that they never preempt each other.
+ *
+ * @return  none
+ */
+void I2CQ_Init(void)
+{
+    DMA_InitTypeDef DMA_InitStructure = {0};
+    NVIC_InitTypeDef NVIC_InitStructure = {0};
+
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOC, ENABLE);
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_I2C1, ENABLE);
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+    pins(GPIO_Mode_AF_OD);
+
+    /* DMA1 channel 6: I2C1 TX, channel 7: I2C1 RX with transfer-complete interrupt */
+    DMA_DeInit(DMA1_Channel6);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&I2C1->DATAR;
+    DMA_InitStructure.DMA_MemoryBaseAddr = 0;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+    DMA_InitStructure.DMA_BufferSize = 0;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init(DMA1_Channel6, &DMA_InitStructure);
+
+    DMA_DeInit(DMA1_Channel7);
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_Init(DMA1_Channel7, &DMA_InitStructure);
+    DMA_ITConfig(DMA1_Channel7, DMA_IT_TC, ENABLE);
+
+    setup();
+    CLKGOV_Register(i2c_clock);         /* Keep SCL at I2CQ_SPEED on clock switches */
+
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_InitStructure.NVIC_IRQChannel = I2C1_EV_IRQn;
+    NVIC_Init(&NVIC_InitStructure);
+    NVIC_InitStructure.NVIC_IRQChannel = I2C1_ER_IRQn;
+    NVIC_Init(&NVIC_InitStructure);
+    NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel7_IRQn;
+    NVIC_Init(&NVIC_InitStructure);
+}
+
+/*********************************************************************
+ * @fn      I2CQ_Submit
+ *
+ * @brief   Queues a transaction, starting it if the bus is idle.
+ *
+ * @param   x - Transaction, Status is set to I2CQ_PENDING.
+ *
+ * @return  1 - queued, 0 - the queue is full
+ */
+uint8_t I2CQ_Submit(I2CQ_XferTypeDef *x)
+{
+    if ((uint8_t)(QHead - QTail) >= I2CQ_DEPTH) return 0;
+
+    x->Status = I2CQ_PENDING;
+    __disable_irq();
+    Queue[QHead % I2CQ_DEPTH] = x;
+    QHead++;
+    if (!Cur) start_next();
+    __enable_irq();
+    return 1;
+}
+
+/*********************************************************************
+ * @fn      I2CQ_Busy
+ *
+ * @brief   Tells whether transactions are still queued or running.
+ *
+ * @return  1 - busy, 0 - idle
+ */
+uint8_t I2CQ_Busy(void)
+{
+    return Cur != 0;
+}
+
+/*********************************************************************
+ * @fn      I2CQ_Timerproc
+ *
+ * @brief   Counts down the timeout of the running transaction, to be
+ *        called every 1ms from SysTick. The transaction is ended from
+ *        the error interrupt, which cannot preempt the other I2C
+ *        interrupts.
+ *
+ * @return  none
+ */
+void I2CQ_Timerproc(void)
+{
+    if (Timer && --Timer == 0) {
+        Abort = I2CQ_TIMEOUT;
+        NVIC_SetPendingIRQ(I2C1_ER_IRQn);
+    }
+}
+
+/*********************************************************************
+ * @fn      I2C1_EV_IRQHandler
+ *
+ * @brief   Start sent: address. Address acknowledged: DMA for the
+ *        phase. Write phase finished (BTF once DMA has run out):
+ *        repeated start for the read, or STOP.
+ *
+ * @return  none
+ */
+void I2C1_EV_IRQHandler(void)
+{
+    uint16_t sr1 = I2C1->STAR1;
+
+    if (!Cur) {
+        (void)I2C1->STAR2;                  /* Stray event after an abort */
+        return;
+    }
+
+    if (sr1 & I2C_STAR1_SB) {
+        I2C1->DATAR = (uint16_t)((Cur->Addr << 1) | Reading);
+    } else if (sr1 & I2C_STAR1_ADDR) {
+        if (!Reading) {
+            dma_start(DMA1_Channel6, Cur->WrBuf, Cur->WrLen);
+            (void)I2C1->STAR2;              /* Clears ADDR */
+        } else if (Cur->RdLen == 1) {
+            dma_start(DMA1_Channel7, Cur->RdBuf, 1);
+            I2C1->CTLR1 &= ~I2C_CTLR1_ACK;  /* NACK the only byte */
+            (void)I2C1->STAR2;
+            I2C1->CTLR1 |= I2C_CTLR1_STOP;
+        } else {
+            dma_start(DMA1_Channel7, Cur->RdBuf, Cur->RdLen);
+            I2C1->CTLR2 |= I2C_CTLR2_LAST;  /* NACK the byte that ends the DMA */
+            (void)I2C1->STAR2;
+        }
+    } else if ((sr1 & I2C_STAR1_BTF) && !Reading && DMA_GetCurrDataCounter_Fast(DMA1_Channel6) == 0) {
+        if (Cur->RdLen) {
+            Reading = 1;                    /* BTF stays set until the start is on the bus */
+            I2C1->CTLR1 |= I2C_CTLR1_START;
+        } else {
+            I2C1->CTLR1 |= I2C_CTLR1_STOP;
+            finish(I2CQ_DONE);
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      DMA1_Channel7_IRQHandler
+ *
+ * @brief   Read phase complete: STOP and on to the next transaction.
+ *
+ * @return  none
+ */
+void DMA1_Channel7_IRQHandler(void)
+{
+    DMA_ClearITPendingBit_Fast(DMA1_IT_GL7);
+    if (!Cur || !Reading) return;
+
+    if (Cur->RdLen > 1) I2C1->CTLR1 |= I2C_CTLR1_STOP;
+    finish(I2CQ_DONE);
+}
+
+/*********************************************************************
+ * @fn      I2C1_ER_IRQHandler
+ *
+ * @brief   NACK: STOP and I2CQ_NACK. Bus error, arbitration lost,
+ *        overrun or timeout: bus recovery.
+ *
+ * @return  none
+ */
+void I2C1_ER_IRQHandler(void)
+{
+    uint16_t sr1 = I2C1->STAR1;
+
+    I2C1->STAR1 = (uint16_t)~(sr1 & STAR1_ERRORS);     /* rc_w0 */
+    if (!Cur) return;
+
+    if (Abort) {
+        recover();
+        finish(Abort);
+    } else if (sr1 & I2C_STAR1_AF) {
+        I2C1->CTLR1 |= I2C_CTLR1_STOP;
+        finish(I2CQ_NACK);
+    } else if (sr1 & STAR1_ERRORS) {
+        recover();
+        finish(I2CQ_BUSERR);
+    }
+}
+
+#endif /* I2CQ_ENABLE */
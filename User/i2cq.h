@@ -0,0 +1,103 @@
+/*********************************************************************************
+ * File Name          : i2cq.h
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Interrupt and DMA driven I2C1 master transaction queue.
+ *********************************************************************************
+ * A transaction writes WrLen bytes to a slave, then, with RdLen set, reads
+ * RdLen bytes after a repeated start: the usual register read of a sensor.
+ * WrLen 0 makes a plain read, RdLen 0 a plain write. The bytes are moved by
+ * DMA1 channel 6 (TX) and channel 7 (RX); the I2C1 event interrupt only runs
+ * for the start, address and end of the write phase, and the channel 7
+ * transfer-complete interrupt closes a read, so the CPU does a handful of
+ * short interrupts per transaction whatever its length.
+ *
+ * I2CQ_Submit queues a transaction and returns at once; the queue is run from
+ * the interrupts, one transaction after the other. A batch (all registers of
+ * all sensors, say, read into consecutive parts of one record) is submitted
+ * as a set of transactions and is complete when the last one leaves
+ * I2CQ_PENDING, while the main loop keeps writing the card.
+ *
+ * A NACK ends a transaction with a STOP and I2CQ_NACK. A bus error, a lost
+ * arbitration or a transaction taking longer than I2CQ_TIMEOUT_MS (counted by
+ * I2CQ_Timerproc from SysTick) resets I2C1; a slave still holding SDA low is
+ * then clocked out with up to 9 SCL pulses and a STOP before the queue goes
+ * on with the next transaction.
+ *
+ * Pins: SCL PC2, SDA PC1, with external pull-ups.
+ *******************************************************************************/
+#ifndef __I2CQ_H
+#define __I2CQ_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "debug.h"
+
+/* I2C Queue Definition */
+#ifndef I2CQ_ENABLE
+#define I2CQ_ENABLE         0
+#endif
+
+#ifndef I2CQ_SPEED
+#define I2CQ_SPEED          400000                  /* SCL rate in Hz */
+#endif
+
+#ifndef I2CQ_DEPTH
+#define I2CQ_DEPTH          8                       /* Queued transactions, power of 2 */
+#endif
+
+#ifndef I2CQ_TIMEOUT_MS
+#define I2CQ_TIMEOUT_MS     10                      /* Longest transaction, start to stop */
+#endif
+
+#if (I2CQ_DEPTH & (I2CQ_DEPTH - 1)) || (I2CQ_DEPTH > 128)
+#error I2CQ_DEPTH must be a power of 2 up to 128
+#endif
+
+/* Transaction status */
+#define I2CQ_DONE           0
+#define I2CQ_PENDING        1                       /* Queued or running */
+#define I2CQ_NACK           2                       /* Address or data not acknowledged */
+#define I2CQ_BUSERR         3                       /* Bus error or arbitration lost */
+#define I2CQ_TIMEOUT        4
+
+/* Transaction, left in place until it is no longer I2CQ_PENDING */
+typedef struct
+{
+    uint8_t  Addr;          /* 7-bit slave address */
+    uint8_t  WrLen;         /* Bytes written first, e.g. the register address */
+    uint16_t RdLen;         /* Bytes read after a repeated start */
+    const uint8_t *WrBuf;
+    uint8_t *RdBuf;
+    volatile uint8_t Status;
+} I2CQ_XferTypeDef;
+
+/* I2C queue statistics */
+typedef struct
+{
+    uint32_t Xfers;         /* Transactions completed with I2CQ_DONE */
+    uint32_t Nacks;
+    uint32_t BusErrors;
+    uint32_t Timeouts;
+    uint32_t Recoveries;    /* Resets of I2C1 */
+    uint32_t BusClears;     /* Recoveries that had to clock out a slave */
+} I2CQ_StatTypeDef;
+
+#if I2CQ_ENABLE
+extern volatile I2CQ_StatTypeDef I2CQ_Stat;
+
+void        I2CQ_Init(void);
+uint8_t     I2CQ_Submit(I2CQ_XferTypeDef *x);
+uint8_t     I2CQ_Busy(void);
+void        I2CQ_Timerproc(void);
+#else
+#define I2CQ_Timerproc()                ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __I2CQ_H */
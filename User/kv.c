@@ -0,0 +1,243 @@
+/*********************************************************************************
+ * File Name          : kv.c
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Log-structured key-value store in the MCU flash.
+ *******************************************************************************/
+#include <stddef.h>
+#include <string.h>
+#include "kv.h"
+#include "crc32.h"
+
+#if KV_ENABLE
+
+#define NONE        0xFF                /* Index entry of a key without value */
+#define DELETED     0xFF                /* Len of a delete record */
+
+/* One record per page */
+typedef struct
+{
+    uint32_t Seq;
+    uint8_t  Key;
+    uint8_t  Len;
+    uint16_t Pad;
+    uint8_t  Val[KV_VALUE_MAX];
+    uint32_t Crc;                       /* CRC-32 of the bytes before */
+} KV_RecordTypeDef;
+
+extern uint8_t _kv_start[], _kv_end[];  /* Ld/Link.ld */
+
+KV_StatTypeDef KV_Stat;
+
+static uint8_t Index[KV_KEYS];          /* Page of the current record of each key */
+static uint8_t Pages;                   /* Pages per bank */
+static uint8_t Bank;                    /* Bank written to */
+static uint8_t Head;                    /* Next page to write */
+static uint32_t Seq;                    /* Last sequence number written */
+
+/* Pages through the FLASH_BASE alias, as the programming functions expect */
+static const KV_RecordTypeDef *page(uint8_t n)
+{
+    return (const KV_RecordTypeDef *)(FLASH_BASE + (uint32_t)_kv_start + (uint32_t)n * KV_PAGE_SIZE);
+}
+
+static uint8_t valid(const KV_RecordTypeDef *r)
+{
+    return r->Key < KV_KEYS && (r->Len <= KV_VALUE_MAX || r->Len == DELETED) &&
+           CRC32_Update(0, r, offsetof(KV_RecordTypeDef, Crc)) == r->Crc;
+}
+
+static uint8_t program(uint8_t n, KV_RecordTypeDef *r)
+{
+    uint32_t addr = (uint32_t)page(n);
+    const uint32_t *w = (const uint32_t *)r;
+    uint8_t i;
+
+    r->Seq = ++Seq;
+    r->Pad = 0xFFFF;
+    r->Crc = CRC32_Update(0, r, offsetof(KV_RecordTypeDef, Crc));
+
+    FLASH_Unlock_Fast();
+    FLASH_ErasePage_Fast(addr);
+    FLASH_BufReset();
+    for (i = 0; i < KV_PAGE_SIZE / 4; i++) {
+        FLASH_BufLoad(addr + 4 * i, w[i]);
+    }
+    FLASH_ProgramPage_Fast(addr);
+    FLASH_Lock_Fast();
+    FLASH_Lock();
+    KV_Stat.Writes++;
+
+    return memcmp(page(n), r, KV_PAGE_SIZE) ? KV_EFLASH : KV_OK;
+}
+
+/* Appends a copy of the current record of every key still outside Bank */
+static uint8_t relocate(void)
+{
+    KV_RecordTypeDef r;
+    uint8_t k, res;
+
+    for (k = 0; k < KV_KEYS; k++) {
+        if (Index[k] == NONE || Index[k] / Pages == Bank) continue;
+        if (Head == (Bank + 1) * Pages) return KV_FULL;
+        memcpy(&r, page(Index[k]), sizeof r);
+        res = program(Head, &r);
+        if (res != KV_OK) return res;
+        Index[k] = Head++;
+    }
+    return KV_OK;
+}
+
+/* Moves to the other bank, erased first, with the current records only */
+static uint8_t compact(void)
+{
+    uint8_t n;
+
+    Bank ^= 1;
+    Head = Bank * Pages;
+    FLASH_Unlock_Fast();
+    for (n = Head; n < Head + Pages; n++) {
+        FLASH_ErasePage_Fast((uint32_t)page(n));
+    }
+    FLASH_Lock_Fast();
+    FLASH_Lock();
+    KV_Stat.Compactions++;
+
+    return relocate();
+}
+
+/* Appends a record, compacting first if the bank is full */
+static uint8_t append(KV_RecordTypeDef *r)
+{
+    uint8_t res;
+
+    if (Head == (Bank + 1) * Pages) {
+        res = compact();
+        if (res != KV_OK) return res;
+        if (Head == (Bank + 1) * Pages) return KV_FULL;
+    }
+    res = program(Head, r);
+    if (res != KV_OK) return res;
+    Index[r->Key] = (r->Len == DELETED) ? NONE : Head;
+    Head++;
+    return KV_OK;
+}
+
+/*********************************************************************
+ * @fn      KV_Init
+ *
+ * @brief   Scans the flash region, builds the RAM index and finishes a
+ *        compaction cut short by a reset. An empty or foreign region
+ *        is erased.
+ *
+ * @return  none
+ */
+void KV_Init(void)
+{
+    const KV_RecordTypeDef *r;
+    uint8_t n, last = NONE, k;
+
+    Pages = (uint8_t)((_kv_end - _kv_start) / KV_PAGE_SIZE / 2);
+    memset(Index, NONE, sizeof Index);
+    Seq = 0;
+
+    for (n = 0; n < 2 * Pages; n++) {
+        r = page(n);
+        if (!valid(r)) continue;
+        if (Index[r->Key] == NONE || r->Seq > page(Index[r->Key])->Seq) Index[r->Key] = n;
+        if (last == NONE || r->Seq > Seq) {
+            Seq = r->Seq;
+            last = n;
+        }
+    }
+    for (k = 0; k < KV_KEYS; k++) {
+        if (Index[k] != NONE && page(Index[k])->Len == DELETED) Index[k] = NONE;
+    }
+
+    if (last == NONE) {
+        Bank = 1;
+        compact();                      /* Erase bank 0 and start there */
+    } else {
+        Bank = last / Pages;
+        Head = last + 1;
+        relocate();
+    }
+}
+
+/*********************************************************************
+ * @fn      KV_Get
+ *
+ * @brief   Reads the value of a key.
+ *
+ * @param   key - 0..KV_KEYS-1.
+ *          buf - Receives up to size bytes of the value.
+ *          size - Size of buf.
+ *
+ * @return  Length of the value (may exceed size), -1 if the key has none
+ */
+int KV_Get(uint8_t key, void *buf, uint8_t size)
+{
+    const KV_RecordTypeDef *r;
+
+    if (key >= KV_KEYS || Index[key] == NONE) return -1;
+    r = page(Index[key]);
+    memcpy(buf, r->Val, r->Len < size ? r->Len : size);
+    return r->Len;
+}
+
+/*********************************************************************
+ * @fn      KV_Set
+ *
+ * @brief   Stores the value of a key. Nothing is written when the key
+ *        already has this value.
+ *
+ * @param   key - 0..KV_KEYS-1.
+ *          val - Value.
+ *          len - 0..KV_VALUE_MAX.
+ *
+ * @return  KV_OK, KV_FULL, KV_EFLASH or KV_EPARAM
+ */
+uint8_t KV_Set(uint8_t key, const void *val, uint8_t len)
+{
+    KV_RecordTypeDef r;
+    const KV_RecordTypeDef *cur;
+
+    if (key >= KV_KEYS || len > KV_VALUE_MAX) return KV_EPARAM;
+    if (Index[key] != NONE) {
+        cur = page(Index[key]);
+        if (cur->Len == len && memcmp(cur->Val, val, len) == 0) {
+            KV_Stat.Unchanged++;
+            return KV_OK;
+        }
+    }
+
+    memset(&r, 0xFF, sizeof r);
+    r.Key = key;
+    r.Len = len;
+    memcpy(r.Val, val, len);
+    return append(&r);
+}
+
+/*********************************************************************
+ * @fn      KV_Delete
+ *
+ * @brief   Removes the value of a key.
+ *
+ * @param   key - 0..KV_KEYS-1.
+ *
+ * @return  KV_OK, KV_FULL, KV_EFLASH or KV_EPARAM
+ */
+uint8_t KV_Delete(uint8_t key)
+{
+    KV_RecordTypeDef r;
+
+    if (key >= KV_KEYS) return KV_EPARAM;
+    if (Index[key] == NONE) return KV_OK;
+
+    memset(&r, 0xFF, sizeof r);
+    r.Key = key;
+    r.Len = DELETED;
+    return append(&r);
+}
+
+#endif /* KV_ENABLE */
@@ -0,0 +1,81 @@
+/*********************************************************************************
+ * File Name          : kv.h
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Log-structured key-value store in the MCU flash.
+ *********************************************************************************
+ * Small configuration values and counters are kept in the flash reserved at
+ * the top by Ld/Link.ld (__kv_size, 1KB = 16 pages of 64 bytes), so reading
+ * them at boot needs neither the card nor FatFs.
+ *
+ * The region is split in two banks. Each KV_Set appends one record page to
+ * the active bank with the fast page erase/program of ch32v00x_flash.c:
+ *
+ *   seq(4) key(1) len(1) 0xFFFF(2) value(KV_VALUE_MAX) crc32(4)
+ *
+ * The newest valid record of a key (highest seq, CRC correct) is its value;
+ * KV_Delete appends a record with len 0xFF. When the active bank is full, the
+ * other bank is erased and the current record of every key is copied over
+ * with new sequence numbers, then the writes go on there: the pages are used
+ * in turn, so they wear evenly. A power loss at any point leaves either the
+ * old or the new record of a key valid; an interrupted compaction is finished
+ * by KV_Init.
+ *
+ * KV_Init scans the pages once and builds the index of key to page in RAM
+ * (KV_KEYS bytes). KV_Get is then a table lookup and a copy from flash. At
+ * most one key less than a bank has pages can be stored.
+ *
+ * The CPU stalls for the erase and program of each page, interrupts
+ * included; do not call KV_Set while a DMA ring is being serviced.
+ *******************************************************************************/
+#ifndef __KV_H
+#define __KV_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "debug.h"
+
+/* Key-Value Store Definition */
+#ifndef KV_ENABLE
+#define KV_ENABLE           0
+#endif
+
+#ifndef KV_KEYS
+#define KV_KEYS             32                      /* Keys 0..KV_KEYS-1, one RAM index byte each */
+#endif
+
+#define KV_PAGE_SIZE        64                      /* Fast program page */
+#define KV_VALUE_MAX        52                      /* Value bytes in a record page */
+
+/* KV_Set/KV_Delete results */
+#define KV_OK               0
+#define KV_FULL             1                       /* No room left for a new key */
+#define KV_EFLASH           2                       /* Read back after programming failed */
+#define KV_EPARAM           3                       /* Key or length out of range */
+
+/* Key-value store statistics */
+typedef struct
+{
+    uint32_t Writes;        /* Record pages programmed, compaction included */
+    uint32_t Unchanged;     /* KV_Set calls with the stored value, not written */
+    uint32_t Compactions;
+} KV_StatTypeDef;
+
+#if KV_ENABLE
+extern KV_StatTypeDef KV_Stat;
+
+void    KV_Init(void);
+int     KV_Get(uint8_t key, void *buf, uint8_t size);
+uint8_t KV_Set(uint8_t key, const void *val, uint8_t len);
+uint8_t KV_Delete(uint8_t key);
+#else
+#define KV_Init()                       ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KV_H */
@@ -0,0 +1,157 @@
+/*********************************************************************************
+ * File Name          : lplog.c
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Duty-cycled low-power logger (standby + auto wake-up).
+ *******************************************************************************/
+#include "lplog.h"
+#include "diskio.h"
+
+#if LPLOG_ENABLE
+
+LPLOG_StatTypeDef LPLOG_Stat;
+
+static BYTE Sector[512] __attribute__((aligned(4)));   /* Kept through standby with the rest of SRAM */
+static uint16_t Fill;               /* Bytes in Sector */
+static uint16_t Retry;              /* Wake-ups left before the next card init attempt */
+
+/* AWU on LSI, raising the EXTI line 9 event that ends the standby WFE */
+static void awu_init(void)
+{
+    EXTI_InitTypeDef EXTI_InitStructure = {0};
+
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_PWR, ENABLE);
+    RCC_LSICmd(ENABLE);
+    while (RCC_GetFlagStatus(RCC_FLAG_LSIRDY) == RESET);
+
+    EXTI_InitStructure.EXTI_Line = EXTI_Line9;
+    EXTI_InitStructure.EXTI_Mode = EXTI_Mode_Event;
+    EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Falling;
+    EXTI_InitStructure.EXTI_LineCmd = ENABLE;
+    EXTI_Init(&EXTI_InitStructure);
+
+    PWR_AWU_SetPrescaler(LPLOG_AWU_PRESCALER);
+    PWR_AWU_SetWindowValue(LPLOG_AWU_WINDOW);
+    PWR_AutoWakeUpCmd(ENABLE);
+}
+
+static void standby(void)
+{
+    USART_Printf_Flush();
+    PWR_EnterSTANDBYMode(PWR_STANDBYEntry_WFE);
+    SystemInit();           /* Standby wakes up on HSI, restore the SYSCLK_FREQ_xxx clock */
+    LPLOG_Stat.Wakes++;
+}
+
+/* Writes the full sector, powering the card up first if needed */
+static FRESULT flush(FIL *fp)
+{
+    uint32_t t0 = SysTick->CNT, t;
+    FRESULT res = FR_OK;
+    UINT bw;
+#if LPLOG_CARD_OFF
+    BYTE pwr = 0;
+#endif
+
+    if (disk_status(0) & STA_NOINIT) {
+        LPLOG_Stat.Inits++;
+        if (disk_initialize(0) & STA_NOINIT) res = FR_NOT_READY;
+        t = SysTick->CNT - t0;
+        if (t > LPLOG_Stat.InitMax) LPLOG_Stat.InitMax = t;
+    }
+    if (res == FR_OK) {
+        res = f_write(fp, Sector, sizeof Sector, &bw);
+        if (res == FR_OK && bw != sizeof Sector) res = FR_DENIED;   /* Volume full */
+        if (res == FR_OK) {
+            Fill = 0;
+            if (++LPLOG_Stat.Sectors % LPLOG_SYNC_SECTORS == 0) res = f_sync(fp);
+        }
+    }
+#if LPLOG_CARD_OFF
+    disk_ioctl(0, CTRL_POWER, &pwr);
+#endif
+    LPLOG_Stat.CardTicks += SysTick->CNT - t0;
+    return res;
+}
+
+/*********************************************************************
+ * @fn      LPLOG_Run
+ *
+ * @brief   Logs one record per AWU wake-up to a file, sleeping in
+ *        standby in between. Does not return before the record count
+ *        is reached or on an error other than a failed card init.
+ *        A partly filled sector is left in RAM on return.
+ *
+ * @param   fp - File opened for writing, at a sector boundary.
+ *          sample - Fills the sample bytes of each record.
+ *          records - Records to log, 0 for no limit.
+ *
+ * @return  FR_OK, FR_DENIED on volume full, or the f_write/f_sync error.
+ */
+FRESULT LPLOG_Run(FIL *fp, LPLOG_SampleTypeDef sample, uint32_t records)
+{
+    FRESULT res = FR_OK;
+    uint32_t t0;
+
+    awu_init();
+    for (;;) {
+        t0 = SysTick->CNT;
+        if (Fill < sizeof Sector) {
+            *(uint32_t *)&Sector[Fill] = LPLOG_Stat.Records + LPLOG_Stat.Lost;
+            sample(&Sector[Fill + 4]);
+            Fill += LPLOG_REC_SIZE;
+            LPLOG_Stat.Records++;
+        } else {
+            LPLOG_Stat.Lost++;
+        }
+
+        if (Fill == sizeof Sector) {
+            if (Retry) {
+                Retry--;
+            } else {
+                res = flush(fp);
+                if (res == FR_NOT_READY) {
+                    LPLOG_Stat.InitFails++;
+                    Retry = LPLOG_RETRY_WAKES;
+                    res = FR_OK;
+                }
+            }
+        }
+        LPLOG_Stat.AwakeTicks += SysTick->CNT - t0;
+
+        if (res != FR_OK || (records && LPLOG_Stat.Records >= records)) break;
+        standby();
+    }
+    return res;
+}
+
+/*********************************************************************
+ * @fn      LPLOG_Dump
+ *
+ * @brief   Prints the statistics and the charge estimate:
+ *
+ *            LPLOG records:3600 lost:0 wakes:3599 sectors:56 inits:56 fails:0
+ *            LPLOG init_max:38ms awake:2210ms card:1890ms rec_per_mAh:412000
+ *
+ * @return  none
+ */
+void LPLOG_Dump(void)
+{
+    uint32_t per_ms = SystemCoreClock / 8000;
+    uint32_t awake_ms = (uint32_t)(LPLOG_Stat.AwakeTicks / per_ms);
+    uint32_t card_ms = (uint32_t)(LPLOG_Stat.CardTicks / per_ms);
+    uint64_t sleep_ms = (uint64_t)LPLOG_Stat.Wakes * LPLOG_AWU_WINDOW * LPLOG_AWU_PERIOD_MS;
+    uint64_t uams;          /* Charge in uA x ms */
+
+    uams = sleep_ms * LPLOG_UA_STANDBY + (uint64_t)awake_ms * LPLOG_UA_RUN + (uint64_t)card_ms * LPLOG_UA_CARD;
+    if (uams == 0) uams = 1;
+
+    printf("LPLOG records:%d lost:%d wakes:%d sectors:%d inits:%d fails:%d\r\n",
+           LPLOG_Stat.Records, LPLOG_Stat.Lost, LPLOG_Stat.Wakes, LPLOG_Stat.Sectors,
+           LPLOG_Stat.Inits, LPLOG_Stat.InitFails);
+    printf("LPLOG init_max:%dms awake:%dms card:%dms rec_per_mAh:%d\r\n",
+           LPLOG_Stat.InitMax / per_ms, awake_ms, card_ms,
+           (uint32_t)((uint64_t)LPLOG_Stat.Records * 3600000000ULL / uams));   /* 1mAh = 3.6e9 uA x ms */
+}
+
+#endif /* LPLOG_ENABLE */
@@ -0,0 +1,117 @@
+/*********************************************************************************
+ * File Name          : lplog.h
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Duty-cycled low-power logger (standby + auto wake-up).
+ *********************************************************************************
+ * The CH32V003 keeps SRAM and the register state in standby and resumes after
+ * the WFE on an AWU wake-up, so the FATFS and FIL objects and a one-sector
+ * record buffer simply live through the sleep: a wake-up costs one call of the
+ * sample hook, not a reset, a card init and an f_mount.
+ *
+ * Each wake-up appends a LPLOG_REC_SIZE byte record (32-bit sequence number,
+ * then the bytes filled by the sample hook) to the buffer. Only when a whole
+ * sector has accumulated is the card touched: one aligned 512-byte f_write,
+ * which FatFs sends straight to the card, and an f_sync every
+ * LPLOG_SYNC_SECTORS sectors. A file preallocated by Host/ffprep avoids the FAT
+ * updates as well.
+ *
+ * With LPLOG_CARD_OFF the card is powered down after each flush through
+ * disk_ioctl(CTRL_POWER) and the MMC_POWER_ON()/MMC_POWER_OFF() hooks of
+ * diskio.c (to be defined for the board's supply switch). The re-init before
+ * the next flush is bounded by MMC_INIT_MS; when it fails the sector stays
+ * buffered and the card is retried LPLOG_RETRY_WAKES wake-ups later, records
+ * that do not fit meanwhile are counted as lost.
+ *
+ * LPLOG_Dump estimates records per mAh from the measured awake and card times
+ * and the currents LPLOG_UA_xxx of the board.
+ *
+ * The clock is restored with SystemInit after each wake-up; with CLKGOV keep
+ * the governor at the SystemInit level while logging.
+ *******************************************************************************/
+#ifndef __LPLOG_H
+#define __LPLOG_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "debug.h"
+#include "ff.h"
+
+/* Low-Power Logger Definition */
+#ifndef LPLOG_ENABLE
+#define LPLOG_ENABLE        0
+#endif
+
+#ifndef LPLOG_REC_SIZE
+#define LPLOG_REC_SIZE      8                       /* Divides 512, 4 bytes sequence + sample */
+#endif
+
+#ifndef LPLOG_AWU_PRESCALER
+#define LPLOG_AWU_PRESCALER PWR_AWU_Prescaler_10240 /* Define LPLOG_AWU_PERIOD_MS along with it */
+#define LPLOG_AWU_PERIOD_MS 80                      /* Window count period (LSI 128kHz / 10240) */
+#endif
+
+#ifndef LPLOG_AWU_WINDOW
+#define LPLOG_AWU_WINDOW    12                      /* Wake-up every 12 counts (~1s), up to 63 */
+#endif
+
+#ifndef LPLOG_SYNC_SECTORS
+#define LPLOG_SYNC_SECTORS  8                       /* f_sync interval in sectors */
+#endif
+
+#ifndef LPLOG_CARD_OFF
+#define LPLOG_CARD_OFF      0                       /* Power the card down between flushes */
+#endif
+
+#ifndef LPLOG_RETRY_WAKES
+#define LPLOG_RETRY_WAKES   16                      /* Wake-ups to wait after a failed card init */
+#endif
+
+/* Board currents for the records per mAh estimate */
+#ifndef LPLOG_UA_STANDBY
+#define LPLOG_UA_STANDBY    10                      /* MCU in standby, card off or idle */
+#endif
+
+#ifndef LPLOG_UA_RUN
+#define LPLOG_UA_RUN        6000                    /* MCU running at SYSCLK_FREQ_xxx */
+#endif
+
+#ifndef LPLOG_UA_CARD
+#define LPLOG_UA_CARD       25000                   /* Card initializing or writing, on top of RUN */
+#endif
+
+#if (512 % LPLOG_REC_SIZE) || (LPLOG_REC_SIZE < 4)
+#error LPLOG_REC_SIZE must divide 512 and hold the sequence number
+#endif
+
+/* Fills the LPLOG_REC_SIZE - 4 sample bytes of a record */
+typedef void (*LPLOG_SampleTypeDef)(uint8_t *buf);
+
+/* Logger statistics, times in SysTick counts */
+typedef struct
+{
+    uint32_t Records;       /* Records buffered */
+    uint32_t Lost;          /* Records dropped while the card could not be written */
+    uint32_t Wakes;         /* AWU wake-ups */
+    uint32_t Sectors;       /* Sectors written */
+    uint32_t Inits;         /* Card initializations */
+    uint32_t InitFails;
+    uint32_t InitMax;       /* Longest card initialization */
+    uint64_t AwakeTicks;    /* Time out of standby */
+    uint64_t CardTicks;     /* Time spent initializing and writing the card */
+} LPLOG_StatTypeDef;
+
+#if LPLOG_ENABLE
+extern LPLOG_StatTypeDef LPLOG_Stat;
+
+FRESULT LPLOG_Run(FIL *fp, LPLOG_SampleTypeDef sample, uint32_t records);
+void    LPLOG_Dump(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LPLOG_H */
@@ -26,13 +26,103 @@
 
 #include "debug.h"
 #include "ff.h"
+#include "acq.h"
+#include "ulog.h"
+#include "prof.h"
+#include "perf.h"
+#include "dtrace.h"
+#include "sdbench.h"
+#include "clkgov.h"
+#include "lplog.h"
+#include "pfail.h"
+#include "ecap.h"
+#include "kv.h"
+#include "fwup.h"
+#include "sched.h"
 
 /* Global define */
 
+/* Application Definition */
+#define APP_WRITE_TEST  0   /* Write test.txt once */
+#define APP_ADC_LOG     1   /* Record the ACQ_CHANNEL_LIST scans to adc.bin, ACQ reduces in a sched task */
+#define APP_UART_LOG    2   /* Record the USART1 RX stream to uart.bin */
+#define APP_SD_BENCH    3   /* Storage benchmark, rerun from the console */
+#define APP_LP_LOG      4   /* Record one sample per AWU wake-up to lp.bin */
+#define APP_EVENT_LOG   5   /* Record the PD2 edge timestamps to events.bin */
+
+#ifndef APP_MODE
+#define APP_MODE    APP_WRITE_TEST
+#endif
+
+#if (APP_MODE == APP_ADC_LOG) && !ACQ_ENABLE
+#error APP_ADC_LOG needs ACQ_ENABLE = 1
+#endif
+#if (APP_MODE == APP_ADC_LOG) && (!SCHED_ENABLE || !FF_FS_REENTRANT)
+#error APP_ADC_LOG needs SCHED_ENABLE = 1 and FF_FS_REENTRANT = 1
+#endif
+#if (APP_MODE == APP_UART_LOG) && !ULOG_ENABLE
+#error APP_UART_LOG needs ULOG_ENABLE = 1
+#endif
+#if (APP_MODE == APP_SD_BENCH) && !SDBENCH_ENABLE
+#error APP_SD_BENCH needs SDBENCH_ENABLE = 1
+#endif
+#if (APP_MODE == APP_LP_LOG) && !LPLOG_ENABLE
+#error APP_LP_LOG needs LPLOG_ENABLE = 1
+#endif
+#if (APP_MODE == APP_EVENT_LOG) && !ECAP_ENABLE
+#error APP_EVENT_LOG needs ECAP_ENABLE = 1
+#endif
+
+/*
+ * Least stack of the mode, exported to Ld/Link.ld as __app_stack_size. The
+ * deepest chains from main, from -fcallgraph-info=su on a 32-bit host build
+ * with register arguments and 4-byte stack alignment as in RV32EC ilp32e (no
+ * RISC-V figures yet), plus the interrupts: two nested HPE entries of 40, a
+ * handler of up to 24 and SysTick, 16; in SD_BENCH SysTick is the only one.
+ *   FWUP_Run .. f_open .. wait_ready                   616 + 120
+ *   SDBENCH_Run .. churn .. f_open/f_unlink .. xchg    452 + 56
+ *   f_open .. wait_ready .. sched_yield .. reduce_task 436 + 120
+ *   f_open .. wait_ready                               376 + 120
+ */
+#if FWUP_ENABLE
+#define APP_STACK_SIZE  736
+#elif (APP_MODE == APP_SD_BENCH)
+#define APP_STACK_SIZE  512
+#elif (APP_MODE == APP_ADC_LOG)
+#define APP_STACK_SIZE  576
+#else
+#define APP_STACK_SIZE  512
+#endif
+
+#define APP_STR_(x)     #x
+#define APP_STR(x)      APP_STR_(x)
+__asm__(".global __app_stack_size\n\t.set __app_stack_size, " APP_STR(APP_STACK_SIZE));
+
+/* Keys of the flash key-value store */
+#define KV_KEY_BOOTS    0   /* uint32_t, resets counted by main */
+
+#if (APP_MODE == APP_UART_LOG)
+#define USARTx_BAUD     ULOG_BAUD
+#else
+#define USARTx_BAUD     115200
+#endif
 
 /* Global Variable */
 vu8 val;
 
+#if (APP_MODE == APP_LP_LOG)
+#if (LPLOG_REC_SIZE < 6)
+#error LP_Sample needs LPLOG_REC_SIZE of 6 or more
+#endif
+
+/* Sample of the LP log: the port C and D input levels, stands for the sensor read */
+void LP_Sample(uint8_t *buf)
+{
+    buf[0] = (uint8_t)GPIOC->INDR;
+    buf[1] = (uint8_t)GPIOD->INDR;
+}
+#endif
+
 void MMC_GPIO_Init(void){
     GPIO_InitTypeDef GPIO_InitStructure={0};
 
@@ -106,7 +196,7 @@ void USARTx_CFG(void)
     GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IN_FLOATING;
     GPIO_Init(GPIOD, &GPIO_InitStructure);
 
-    USART_InitStructure.USART_BaudRate = 115200;
+    USART_InitStructure.USART_BaudRate = USARTx_BAUD;
     USART_InitStructure.USART_WordLength = USART_WordLength_8b;
     USART_InitStructure.USART_StopBits = USART_StopBits_1;
     USART_InitStructure.USART_Parity = USART_Parity_No;
@@ -137,19 +227,121 @@ int main(void)
     printf("SystemClk:%d\r\n",SystemCoreClock);
     printf( "ChipID:%08x\r\n", DBGMCU_GetCHIPID() );
 
+    KV_Init();
+#if KV_ENABLE
+    uint32_t boots = 0;
+    KV_Get(KV_KEY_BOOTS, &boots, sizeof boots);
+    boots++;
+    KV_Set(KV_KEY_BOOTS, &boots, sizeof boots);
+    printf("Boot:%u\r\n", (unsigned)boots);
+#endif
+
+    USART_Printf_Flush();   //USARTx_CFG reinitializes the printf USART
     USARTx_CFG();
+    CLKGOV_Init();
 
     MMC_GPIO_Init();
     SPI1_Init();
+    PFAIL_Init();
 
-    FATFS fatfs;
-    FIL fil;
+    static FATFS fatfs;     //In .bss, where the Link.ld ASSERT counts it
+    static FIL fil;
     UINT uint;
     FRESULT fres;
 
+    DTRACE_Start();
     fres = f_mount(&fatfs, "", 1);
     if(fres != FR_OK)
         while(1);
+#if FWUP_ENABLE
+    uint8_t fwup = FWUP_Run();      //Does not return after an update
+    if(fwup != FWUP_NONE)
+        printf("FWUP error:%u\r\n", fwup);
+#endif
+
+#if (APP_MODE == APP_ADC_LOG)
+    fres = f_open(&fil, "adc.bin", FA_CREATE_ALWAYS | FA_WRITE);
+    if(fres != FR_OK)
+        while(1);
+    PFAIL_Watch(&fil);
+
+    ACQ_Init();
+    ACQ_Start();
+    do
+    {
+        sched_poll();   //reduce_task, also run from the card waits in ACQ_Poll
+        fres = ACQ_Poll(&fil);
+    } while(fres == FR_OK && !PFAIL_Down());
+    ACQ_Stop();
+    f_close(&fil);
+
+    printf("ADC log:%d blocks:%d overruns:%d raw:%d\r\n", fres, ACQ_Stat.Blocks, ACQ_Stat.Overruns, ACQ_Stat.RawOverruns);
+    PFAIL_Dump();
+    DTRACE_Dump();
+    while(1)
+        PROF_Poll();
+#elif (APP_MODE == APP_UART_LOG)
+    fres = f_open(&fil, "uart.bin", FA_CREATE_ALWAYS | FA_WRITE);
+    if(fres != FR_OK)
+        while(1);
+    PFAIL_Watch(&fil);
+
+    ULOG_Init();
+    ULOG_Start();
+    do
+    {
+        fres = ULOG_Poll(&fil);
+    } while(fres == FR_OK && !PFAIL_Down());
+    ULOG_Stop();
+    ULOG_Flush(&fil);
+    f_close(&fil);
+
+    printf("UART log:%d bytes:%d frames:%d overruns:%d\r\n", fres, ULOG_Stat.Bytes, ULOG_Stat.Frames, ULOG_Stat.Overruns);
+    PFAIL_Dump();
+    DTRACE_Dump();
+    while(1)
+        PROF_Poll();
+#elif (APP_MODE == APP_SD_BENCH)
+    SDBENCH_Run(SDBENCH_AUTORUN);
+    PERF_Dump();
+    DTRACE_Dump();
+    while(1)
+        SDBENCH_Poll();
+#elif (APP_MODE == APP_LP_LOG)
+    fres = f_open(&fil, "lp.bin", FA_OPEN_APPEND | FA_WRITE);
+    if(fres != FR_OK)
+        while(1);
+
+    fres = LPLOG_Run(&fil, LP_Sample, 0);
+    f_close(&fil);
+
+    printf("LP log:%d\r\n", fres);
+    LPLOG_Dump();
+    while(1)
+        PROF_Poll();
+#elif (APP_MODE == APP_EVENT_LOG)
+    fres = f_open(&fil, "events.bin", FA_CREATE_ALWAYS | FA_WRITE);
+    if(fres != FR_OK)
+        while(1);
+    PFAIL_Watch(&fil);
+
+    ECAP_Init();
+    ECAP_Start();
+    do
+    {
+        fres = ECAP_Poll(&fil);
+    } while(fres == FR_OK && !PFAIL_Down());
+    ECAP_Stop();
+    if(fres == FR_OK)
+        fres = ECAP_Flush(&fil);
+    f_close(&fil);
+
+    printf("Event log:%d events:%d misses:%d overruns:%d\r\n", fres, ECAP_Stat.Events, ECAP_Stat.Misses, ECAP_Stat.Overruns);
+    PFAIL_Dump();
+    DTRACE_Dump();
+    while(1)
+        PROF_Poll();
+#endif
 
     fres = f_open(&fil, "test.txt",FA_CREATE_ALWAYS | FA_WRITE );
     if(fres != FR_OK)
@@ -163,7 +355,10 @@ int main(void)
     fres =  f_unmount("");
     if(fres != FR_OK)
         while(1);
+    PERF_Dump();
+    DTRACE_Dump();
 
 
-    while(1);
+    while(1)
+        PROF_Poll();
 }
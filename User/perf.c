@@ -0,0 +1,80 @@
+/*********************************************************************************
+ * File Name          : perf.c
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Hot-path time measurement for FatFs and the disk driver.
+ *******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "perf.h"
+
+#if PERF_ENABLE
+
+PERF_EntryTypeDef PERF_Table[PERF_IDS];
+
+static const char *const Names[PERF_IDS] = {
+    "f_open", "f_read", "f_write", "f_sync", "f_lseek",
+    "move_window", "get_fat", "create_chain", "dir_find",
+    "disk_read", "disk_write"
+};
+
+/*********************************************************************
+ * @fn      PERF_Leave
+ *
+ * @brief   Closes a probe and adds its time to the table. Called by
+ *        PERF_END or at the end of the probe's scope.
+ *
+ * @param   p - Probe declared by PERF_BEGIN.
+ *
+ * @return  none
+ */
+void PERF_Leave(PERF_ProbeTypeDef *p)
+{
+    PERF_EntryTypeDef *e;
+    uint32_t t;
+
+    if (p->Id >= PERF_IDS) return;      /* Closed already by PERF_END */
+    t = PERF_NOW() - p->T0;
+    e = &PERF_Table[p->Id];
+    if (e->Count == 0 || t < e->Min) e->Min = t;
+    if (t > e->Max) e->Max = t;
+    e->Count++;
+    e->Total += t;
+    p->Id = PERF_IDS;
+}
+
+/*********************************************************************
+ * @fn      PERF_Reset
+ *
+ * @brief   Clears the table.
+ *
+ * @return  none
+ */
+void PERF_Reset(void)
+{
+    memset(PERF_Table, 0, sizeof(PERF_Table));
+}
+
+/*********************************************************************
+ * @fn      PERF_Dump
+ *
+ * @brief   Prints the table, one line per probe that has been hit.
+ *
+ * @return  none
+ */
+void PERF_Dump(void)
+{
+    uint8_t i;
+    PERF_EntryTypeDef *e;
+
+    printf("PERF %-12s %8s %10s %8s %8s %8s [%s]\r\n", "id", "count", "total", "min", "avg", "max", PERF_UNIT);
+    for (i = 0; i < PERF_IDS; i++) {
+        e = &PERF_Table[i];
+        if (e->Count) {
+            printf("PERF %-12s %8u %10u %8u %8u %8u\r\n", Names[i], (unsigned)e->Count, (unsigned)e->Total,
+                   (unsigned)e->Min, (unsigned)(e->Total / e->Count), (unsigned)e->Max);
+        }
+    }
+}
+
+#endif /* PERF_ENABLE */
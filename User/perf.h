@@ -0,0 +1,89 @@
+/*********************************************************************************
+ * File Name          : perf.h
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Hot-path time measurement for FatFs and the disk driver.
+ *********************************************************************************
+ * PERF_BEGIN(id) at the top of a function starts a probe that is closed at
+ * every return from it (GCC cleanup attribute), or earlier by PERF_END(id).
+ * The time spent is accumulated in PERF_Table[id] as the call count, total,
+ * minimum and maximum, in PERF_NOW() units (SysTick counts, 8 HCLK cycles).
+ * Times are inclusive, a probe also counts the probes nested in it.
+ *
+ * With PERF_ENABLE = 0 the macros expand to nothing. A host build can define
+ * PERF_NOW() and PERF_UNIT itself, then this header does not need debug.h.
+ *******************************************************************************/
+#ifndef __PERF_H
+#define __PERF_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Performance Probe Definition */
+#ifndef PERF_ENABLE
+#define PERF_ENABLE         0
+#endif
+
+/* Probe IDs */
+#define PERF_F_OPEN         0
+#define PERF_F_READ         1
+#define PERF_F_WRITE        2
+#define PERF_F_SYNC         3
+#define PERF_F_LSEEK        4
+#define PERF_MOVE_WINDOW    5
+#define PERF_GET_FAT        6
+#define PERF_CREATE_CHAIN   7
+#define PERF_DIR_FIND       8
+#define PERF_DISK_READ      9
+#define PERF_DISK_WRITE     10
+#define PERF_IDS            11
+
+#if PERF_ENABLE
+#ifndef PERF_NOW
+#include "debug.h"
+#define PERF_NOW()          (SysTick->CNT)
+#define PERF_UNIT           "SysTick(HCLK/8)"
+#endif
+#ifndef PERF_UNIT
+#define PERF_UNIT           "ticks"
+#endif
+
+/* Accumulated probe times */
+typedef struct
+{
+    uint32_t Count;
+    uint32_t Total;
+    uint32_t Min;
+    uint32_t Max;
+} PERF_EntryTypeDef;
+
+/* Running probe */
+typedef struct
+{
+    uint32_t Id;            /* PERF_IDS when closed */
+    uint32_t T0;
+} PERF_ProbeTypeDef;
+
+extern PERF_EntryTypeDef PERF_Table[PERF_IDS];
+
+void PERF_Leave(PERF_ProbeTypeDef *p);
+void PERF_Reset(void);
+void PERF_Dump(void);
+
+#define PERF_BEGIN(id)      PERF_ProbeTypeDef perf_##id __attribute__((cleanup(PERF_Leave))) = { (id), PERF_NOW() }
+#define PERF_END(id)        PERF_Leave(&perf_##id)
+#else
+#define PERF_BEGIN(id)
+#define PERF_END(id)
+#define PERF_Reset()        ((void)0)
+#define PERF_Dump()         ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PERF_H */
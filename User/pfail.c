@@ -0,0 +1,174 @@
+/*********************************************************************************
+ * File Name          : pfail.c
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Power-fail flush on the PVD brown-out interrupt.
+ *******************************************************************************/
+#include "pfail.h"
+#include "diskio.h"
+
+#if PFAIL_ENABLE
+
+void PVD_IRQHandler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
+
+int ff_mutex_held(int vol);         /* ffsystem.c */
+
+PFAIL_StatTypeDef PFAIL_Stat;
+volatile uint8_t PFAIL_Flushing;
+
+static FIL *File;
+static volatile uint8_t Pending;    /* Event not flushed yet */
+static uint32_t T0;                 /* SysTick count at the event */
+
+/* f_sync of the watched file, run only while neither FatFs nor the card is in use */
+static void flush(void)
+{
+    FATFS *fs = File ? File->obj.fs : 0;
+#if !PFAIL_FSINFO
+    BYTE fsi;
+#endif
+    uint32_t t;
+
+    Pending = 0;
+    if (!fs) return;                /* Not watching or the file is closed */
+
+#if !PFAIL_FSINFO
+    fsi = fs->fsi_flag;
+    fs->fsi_flag = 0;
+#endif
+    PFAIL_Flushing = 1;             /* No task from the card waits: it may run in the interrupt */
+    PFAIL_Stat.LastRes = f_sync(File);
+    PFAIL_Flushing = 0;
+#if !PFAIL_FSINFO
+    fs->fsi_flag = fsi;             /* Still due for the next regular f_sync */
+#endif
+    if (PFAIL_Stat.LastRes == FR_OK) PFAIL_Stat.Flushes++;
+
+    t = SysTick->CNT - T0;
+    PFAIL_Stat.FlushLast = t;
+    if (t > PFAIL_Stat.FlushMax) PFAIL_Stat.FlushMax = t;
+    if (t > PFAIL_BUDGET_MS * (SystemCoreClock / 8000)) PFAIL_Stat.Overruns++;
+}
+
+/*********************************************************************
+ * @fn      PFAIL_Init
+ *
+ * @brief   Enables the PVD at PFAIL_LEVEL and its interrupt on EXTI
+ *        line 8. The interrupt has preemption priority 1 so that the
+ *        SysTick timeouts of the disk driver keep running during the
+ *        flush.
+ *
+ * @return  none
+ */
+void PFAIL_Init(void)
+{
+    EXTI_InitTypeDef EXTI_InitStructure = {0};
+    NVIC_InitTypeDef NVIC_InitStructure = {0};
+
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_PWR, ENABLE);
+    PWR_PVDLevelConfig(PFAIL_LEVEL);
+    PWR_PVDCmd(ENABLE);
+
+    EXTI_InitStructure.EXTI_Line = EXTI_Line8;
+    EXTI_InitStructure.EXTI_Mode = EXTI_Mode_Interrupt;
+    EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Rising;     /* PVDO rises as VDD falls below the level */
+    EXTI_InitStructure.EXTI_LineCmd = ENABLE;
+    EXTI_Init(&EXTI_InitStructure);
+    EXTI_ClearITPendingBit(EXTI_Line8);
+
+    NVIC_InitStructure.NVIC_IRQChannel = PVD_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
+}
+
+/*********************************************************************
+ * @fn      PFAIL_Watch
+ *
+ * @brief   Selects the file flushed on a power failure. The file object
+ *        must stay in place until it is closed or unwatched.
+ *
+ * @param   fp - File opened for writing, 0 to stop watching.
+ *
+ * @return  none
+ */
+void PFAIL_Watch(FIL *fp)
+{
+    File = fp;
+}
+
+/*********************************************************************
+ * @fn      PFAIL_Leave
+ *
+ * @brief   Called by ff_mutex_give when a FatFs call leaves the volume,
+ *        runs a flush the interrupt could not run.
+ *
+ * @param   vol - Volume released.
+ *
+ * @return  none
+ */
+void PFAIL_Leave(int vol)
+{
+    if (Pending && File && File->obj.fs && File->obj.fs->ldrv == vol && !disk_busy()) {
+        flush();
+    }
+}
+
+/*********************************************************************
+ * @fn      PFAIL_DiskIdle
+ *
+ * @brief   Called by disk_release when the card is free again, runs a
+ *        flush the interrupt could not run outside FatFs.
+ *
+ * @return  none
+ */
+void PFAIL_DiskIdle(void)
+{
+    if (Pending && File && File->obj.fs && !ff_mutex_held(File->obj.fs->ldrv)) {
+        flush();
+    }
+}
+
+/*********************************************************************
+ * @fn      PFAIL_Dump
+ *
+ * @brief   Prints the statistics:
+ *
+ *            PFAIL events:1 deferred:1 flushes:1 overruns:0 last:3120us max:3120us res:0
+ *
+ * @return  none
+ */
+void PFAIL_Dump(void)
+{
+    uint32_t per_us = SystemCoreClock / 8000000;
+
+    printf("PFAIL events:%d deferred:%d flushes:%d overruns:%d last:%dus max:%dus res:%d\r\n",
+           PFAIL_Stat.Events, PFAIL_Stat.Deferred, PFAIL_Stat.Flushes, PFAIL_Stat.Overruns,
+           PFAIL_Stat.FlushLast / per_us, PFAIL_Stat.FlushMax / per_us, PFAIL_Stat.LastRes);
+}
+
+/*********************************************************************
+ * @fn      PVD_IRQHandler
+ *
+ * @brief   VDD dropped below PFAIL_LEVEL: flushes the watched file now,
+ *        or on leaving the FatFs call or the card access this interrupt
+ *        has preempted.
+ *
+ * @return  none
+ */
+void PVD_IRQHandler(void)
+{
+    EXTI_ClearITPendingBit(EXTI_Line8);
+    T0 = SysTick->CNT;
+    PFAIL_Stat.Events++;
+    Pending = 1;
+
+    if (File && File->obj.fs && (ff_mutex_held(File->obj.fs->ldrv) || disk_busy())) {
+        PFAIL_Stat.Deferred++;
+        return;
+    }
+    flush();
+}
+
+#endif /* PFAIL_ENABLE */
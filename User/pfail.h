@@ -0,0 +1,107 @@
+/*********************************************************************************
+ * File Name          : pfail.h
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Power-fail flush on the PVD brown-out interrupt.
+ *********************************************************************************
+ * The PVD compares VDD with PFAIL_LEVEL and raises EXTI line 8 when it drops
+ * below. With a hold-up capacitor on the supply that leaves a few ms, enough
+ * for a minimal flush of the watched file: the sector in the FatFs window
+ * (the last data sector with FF_FS_TINY, or the FAT sector, written to both
+ * FATs), then the directory entry with the new size and first cluster and a
+ * CTRL_SYNC. That is f_sync with the FSINFO update held back (PFAIL_FSINFO
+ * 0; the free cluster count is only a hint, written by the next regular
+ * f_sync): at most 4 sector writes and 1 sector read. Data still in the
+ * application buffers (ACQ halves, ULOG ring) is not written.
+ *
+ * The window and the file object belong to whichever FatFs call is running,
+ * so the flush never preempts one. PFAIL needs FF_FS_REENTRANT: the interrupt
+ * flushes at once when the volume mutex is free, otherwise ff_mutex_give runs
+ * the flush when the interrupted call leaves FatFs. Card access outside
+ * FatFs (LPLOG power cycling, SDBENCH spi) is bracketed by disk_claim and
+ * disk_release (diskio.c), and a flush the interrupt defers for it runs on
+ * the disk_release that frees the card. The worst case is then
+ * the rest of one call, keep the f_write sizes of the logger small (one
+ * sector or one ACQ half) so that it stays short. sched_yield() runs no task
+ * during the flush.
+ *
+ * With the flush in place the application can sync rarely (ACQ_SYNC_BLOCKS,
+ * LPLOG_SYNC_SECTORS) and still lose only the buffered data on a power cut.
+ *
+ * The flush time is measured on every event. Size the capacitor for
+ * PFAIL_Stat.FlushMax at the load current, measured with the card under
+ * write:  C >= I x t / (V(PFAIL_LEVEL) - V(card minimum)). Events whose flush
+ * exceeded PFAIL_BUDGET_MS are counted in PFAIL_Stat.Overruns. The flush runs
+ * at the current clock; with CLKGOV keep the card transfers at the BUSY level.
+ *******************************************************************************/
+#ifndef __PFAIL_H
+#define __PFAIL_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "debug.h"
+#include "ff.h"
+
+/* Power-Fail Flush Definition */
+#ifndef PFAIL_ENABLE
+#define PFAIL_ENABLE        0
+#endif
+
+#ifndef PFAIL_LEVEL
+#define PFAIL_LEVEL         PWR_PVDLevel_2V9        /* Threshold, above the card's 2.7V minimum */
+#endif
+
+#ifndef PFAIL_BUDGET_MS
+#define PFAIL_BUDGET_MS     10                      /* Flush time the hold-up capacitor covers */
+#endif
+
+#ifndef PFAIL_FSINFO
+#define PFAIL_FSINFO        0                       /* Update the FSINFO free cluster count as well */
+#endif
+
+#if PFAIL_ENABLE && !FF_FS_REENTRANT
+#error PFAIL needs FF_FS_REENTRANT = 1 in ffconf.h
+#endif
+
+/* Power-fail statistics, times in SysTick counts */
+typedef struct
+{
+    uint32_t Events;        /* PVD interrupts */
+    uint32_t Deferred;      /* Flushes run on leaving a FatFs call or disk_release */
+    uint32_t Flushes;       /* Flushes completed with FR_OK */
+    uint32_t Overruns;      /* Flushes longer than PFAIL_BUDGET_MS */
+    uint32_t FlushLast;     /* Time from the interrupt to the end of the flush */
+    uint32_t FlushMax;
+    FRESULT  LastRes;
+} PFAIL_StatTypeDef;
+
+#if PFAIL_ENABLE
+extern PFAIL_StatTypeDef PFAIL_Stat;
+
+void PFAIL_Init(void);
+void PFAIL_Watch(FIL *fp);
+void PFAIL_Leave(int vol);
+void PFAIL_DiskIdle(void);
+void PFAIL_Dump(void);
+
+extern volatile uint8_t PFAIL_Flushing;     /* Flush in progress, sched_yield() runs no task */
+
+/* VDD currently below PFAIL_LEVEL */
+#define PFAIL_Down()                    (PWR_GetFlagStatus(PWR_FLAG_PVDO) != RESET)
+#else
+#define PFAIL_Init()                    ((void)0)
+#define PFAIL_Watch(fp)                 ((void)0)
+#define PFAIL_Leave(vol)                ((void)0)
+#define PFAIL_DiskIdle()                ((void)0)
+#define PFAIL_Dump()                    ((void)0)
+#define PFAIL_Flushing                  0
+#define PFAIL_Down()                    0
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PFAIL_H */
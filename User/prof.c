@@ -0,0 +1,86 @@
+/*********************************************************************************
+ * File Name          : prof.c
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Statistical PC profiler.
+ *******************************************************************************/
+#include "prof.h"
+
+#if PROF_ENABLE
+
+uint16_t PROF_Hist[PROF_BUCKETS];
+uint16_t PROF_RamHist[PROF_RAM_BUCKETS];
+uint32_t PROF_Other;
+
+/*********************************************************************
+ * @fn      PROF_Reset
+ *
+ * @brief   Clears the histogram.
+ *
+ * @return  none
+ */
+void PROF_Reset(void)
+{
+    uint16_t i;
+
+    __disable_irq();
+    for (i = 0; i < PROF_BUCKETS; i++) PROF_Hist[i] = 0;
+    for (i = 0; i < PROF_RAM_BUCKETS; i++) PROF_RamHist[i] = 0;
+    PROF_Other = 0;
+    __enable_irq();
+}
+
+/*********************************************************************
+ * @fn      PROF_Dump
+ *
+ * @brief   Prints the histogram, one line per non-empty bucket, flash
+ *        then .ramfunc:
+ *
+ *            PROF base:00000000 shift:7 other:0 ram:20000000 rshift:5
+ *            PROF 00000480 1234
+ *            PROF 20000020 321
+ *            PROF end
+ *
+ * @return  none
+ */
+void PROF_Dump(void)
+{
+    uint16_t i;
+
+    printf("PROF base:%08x shift:%d other:%d ram:%08x rshift:%d\r\n", PROF_FLASH_BASE, PROF_BUCKET_SHIFT,
+           PROF_Other, (uint32_t)_ramfunc_vma, PROF_RAM_SHIFT);
+    for (i = 0; i < PROF_BUCKETS; i++) {
+        if (PROF_Hist[i]) {
+            printf("PROF %08x %d\r\n", PROF_FLASH_BASE + ((uint32_t)i << PROF_BUCKET_SHIFT), PROF_Hist[i]);
+        }
+    }
+    for (i = 0; i < PROF_RAM_BUCKETS; i++) {
+        if (PROF_RamHist[i]) {
+            printf("PROF %08x %d\r\n", (uint32_t)_ramfunc_vma + ((uint32_t)i << PROF_RAM_SHIFT), PROF_RamHist[i]);
+        }
+    }
+    printf("PROF end\r\n");
+}
+
+/*********************************************************************
+ * @fn      PROF_Poll
+ *
+ * @brief   Handles a console command received on USART1, if any.
+ *
+ * @return  none
+ */
+void PROF_Poll(void)
+{
+    if (USART1->STATR & USART_FLAG_RXNE) {
+        switch (USART1->DATAR) {
+        case PROF_CMD_DUMP:
+            PROF_Dump();
+            break;
+        case PROF_CMD_RESET:
+            PROF_Reset();
+            break;
+        }
+    }
+}
+
+#endif /* PROF_ENABLE */
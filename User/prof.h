@@ -0,0 +1,89 @@
+/*********************************************************************************
+ * File Name          : prof.h
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Statistical PC profiler.
+ *********************************************************************************
+ * The 1ms SysTick interrupt passes the interrupted PC (mepc) to PROF_Sample,
+ * which counts it in a histogram of flash address buckets of 2^PROF_BUCKET_SHIFT
+ * bytes, or of RAMFUNC code buckets of 2^PROF_RAM_SHIFT bytes from _ramfunc_vma
+ * (Ld/Link.ld; xchg_spi and the SPI block loops run there). PROF_Dump prints
+ * the non-empty buckets over the console and Host/prof.py maps them back to
+ * the symbols of the ELF file.
+ *******************************************************************************/
+#ifndef __PROF_H
+#define __PROF_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "debug.h"
+
+/* Profiler Definition */
+#ifndef PROF_ENABLE
+#define PROF_ENABLE         0
+#endif
+
+#ifndef PROF_BUCKET_SHIFT
+#define PROF_BUCKET_SHIFT   7                       /* 128-byte buckets, 256 bytes of RAM for 16KB */
+#endif
+
+#ifndef PROF_RAM_SHIFT
+#define PROF_RAM_SHIFT      5                       /* 32-byte buckets, 32 bytes of RAM for .ramfunc */
+#endif
+
+#define PROF_FLASH_BASE     0x00000000
+#define PROF_FLASH_SIZE     0x4000
+#define PROF_BUCKETS        (PROF_FLASH_SIZE >> PROF_BUCKET_SHIFT)
+#define PROF_RAM_SIZE       512                     /* __ramfunc_max in Ld/Link.ld */
+#define PROF_RAM_BUCKETS    (PROF_RAM_SIZE >> PROF_RAM_SHIFT)
+
+/* Console commands handled by PROF_Poll */
+#define PROF_CMD_DUMP       'p'
+#define PROF_CMD_RESET      'r'
+
+#if PROF_ENABLE
+extern uint16_t PROF_Hist[PROF_BUCKETS];
+extern uint16_t PROF_RamHist[PROF_RAM_BUCKETS];
+extern uint32_t PROF_Other;
+extern uint8_t _ramfunc_vma[];              /* Ld/Link.ld */
+
+/*********************************************************************
+ * @fn      PROF_Sample
+ *
+ * @brief   Counts one sample, to be called from the tick interrupt.
+ *
+ * @param   pc - Interrupted program counter.
+ *
+ * @return  none
+ */
+static inline void PROF_Sample(uint32_t pc)
+{
+    uint32_t ofs = pc - PROF_FLASH_BASE, rofs = pc - (uint32_t)_ramfunc_vma;
+    uint16_t *h;
+
+    if (ofs < PROF_FLASH_SIZE) {
+        h = &PROF_Hist[ofs >> PROF_BUCKET_SHIFT];
+    } else if (rofs < PROF_RAM_SIZE) {
+        h = &PROF_RamHist[rofs >> PROF_RAM_SHIFT];
+    } else {
+        PROF_Other++;                   /* Neither flash nor .ramfunc */
+        return;
+    }
+    if (*h != 0xFFFF) (*h)++;           /* Saturate */
+}
+
+void PROF_Reset(void);
+void PROF_Dump(void);
+void PROF_Poll(void);
+#else
+#define PROF_Sample(pc)     ((void)0)
+#define PROF_Poll()         ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PROF_H */
@@ -0,0 +1,105 @@
+/*********************************************************************************
+ * File Name          : sched.c
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Stackless cooperative scheduler (protothread style).
+ *******************************************************************************/
+#include "sched.h"
+#include "pfail.h"
+
+#if SCHED_ENABLE
+
+static sched_task_t *TaskList;  /* Run list in order of registration */
+static uint8_t Yielding;        /* sched_yield() is in progress */
+
+/*********************************************************************
+ * @fn      run_tasks
+ *
+ * @brief   Run every runnable task once.
+ *
+ * @param   mask - Flags a task must have to be run (0:all tasks).
+ *
+ * @return  none
+ */
+static void run_tasks(uint8_t mask)
+{
+    sched_task_t *t;
+
+    for (t = TaskList; t; t = t->next) {
+        if (t->flags & (SCHED_ACTIVE | SCHED_DONE)) continue;  /* On the stack already or finished */
+        if ((t->flags & mask) != mask) continue;
+        t->flags |= SCHED_ACTIVE;
+        if (t->func(t) == SCHED_EXITED) t->flags |= SCHED_DONE;
+        t->flags &= ~SCHED_ACTIVE;
+    }
+}
+
+/*********************************************************************
+ * @fn      sched_add
+ *
+ * @brief   Register a task at the end of the run list.
+ *
+ * @param   t - Task object, it must stay valid while the scheduler runs.
+ *          func - Task body.
+ *          flags - SCHED_NESTABLE or 0.
+ *
+ * @return  none
+ */
+void sched_add(sched_task_t *t, uint8_t (*func)(sched_task_t *t), uint8_t flags)
+{
+    sched_task_t **p;
+
+    t->lc = 0;
+    t->flags = flags & SCHED_NESTABLE;
+    t->func = func;
+    t->next = 0;
+    for (p = &TaskList; *p; p = &(*p)->next) ;
+    *p = t;
+}
+
+/*********************************************************************
+ * @fn      sched_poll
+ *
+ * @brief   Run one round of all the tasks. Use it in a super loop that
+ *        has other work to do, otherwise use sched_run.
+ *
+ * @return  none
+ */
+void sched_poll(void)
+{
+    run_tasks(0);
+}
+
+/*********************************************************************
+ * @fn      sched_run
+ *
+ * @brief   Run the tasks forever.
+ *
+ * @return  none
+ */
+void sched_run(void)
+{
+    while (1) {
+        run_tasks(0);
+    }
+}
+
+/*********************************************************************
+ * @fn      sched_yield
+ *
+ * @brief   Give the nestable tasks a round from inside a busy wait. It
+ *        does not nest, so the stack grows by one task body at most, and
+ *        runs nothing during a PFAIL flush, which may be in the PVD
+ *        interrupt.
+ *
+ * @return  none
+ */
+void sched_yield(void)
+{
+    if (Yielding || PFAIL_Flushing) return;   /* A power-fail flush has the CPU to itself */
+    Yielding = 1;
+    run_tasks(SCHED_NESTABLE);
+    Yielding = 0;
+}
+
+#endif /* SCHED_ENABLE */
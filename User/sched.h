@@ -0,0 +1,86 @@
+/*********************************************************************************
+ * File Name          : sched.h
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : Stackless cooperative scheduler (protothread style).
+ *********************************************************************************
+ * Tasks are plain functions resumed at the line they last stopped on. They keep
+ * no stack of their own, so every task local that must survive a PT_YIELD or
+ * PT_WAIT_UNTIL has to live in the task object (embed sched_task_t as the first
+ * member of a larger struct) or in a static.
+ *
+ * A task that is flagged SCHED_NESTABLE may also be run from inside a driver
+ * wait loop (wait_ready / data token polling in diskio.c) through sched_yield().
+ * Such a task runs on top of the waiting stack and must not call FatFs.
+ *******************************************************************************/
+#ifndef __SCHED_H
+#define __SCHED_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Scheduler Definition */
+#ifndef SCHED_ENABLE
+#define SCHED_ENABLE    0
+#endif
+
+/* Task return status */
+#define SCHED_WAITING   0   /* Blocked in PT_WAIT_UNTIL */
+#define SCHED_YIELDED   1   /* Gave up the CPU in PT_YIELD */
+#define SCHED_EXITED    2   /* Reached PT_END or PT_EXIT */
+
+/* Task flags */
+#define SCHED_NESTABLE  0x01    /* Can be run from sched_yield() (must not call FatFs) */
+#define SCHED_ACTIVE    0x02    /* Task body is on the stack (internal) */
+#define SCHED_DONE      0x04    /* Task has exited (internal) */
+
+typedef struct sched_task sched_task_t;
+
+struct sched_task {
+    uint16_t lc;                            /* Local continuation (0:start) */
+    uint8_t flags;                          /* SCHED_xxx flags */
+    uint8_t (*func)(sched_task_t *t);       /* Task body */
+    sched_task_t *next;                     /* Next task in the run list */
+};
+
+/* Protothread primitives, to be used only in a task body */
+#define PT_BEGIN(t)         switch ((t)->lc) { case 0:
+#define PT_END(t)           } (t)->lc = 0; return SCHED_EXITED
+#define PT_YIELD(t)         do { (t)->lc = __LINE__; return SCHED_YIELDED; case __LINE__:; } while (0)
+#define PT_WAIT_UNTIL(t, c) do { (t)->lc = __LINE__; case __LINE__: if (!(c)) return SCHED_WAITING; } while (0)
+#define PT_WAIT_WHILE(t, c) PT_WAIT_UNTIL((t), !(c))
+#define PT_EXIT(t)          do { (t)->lc = 0; return SCHED_EXITED; } while (0)
+#define PT_RESTART(t)       do { (t)->lc = 0; return SCHED_YIELDED; } while (0)
+
+/* Mutex for the cooperative tasks (0:free, 1:taken) */
+typedef volatile uint8_t sched_mutex_t;
+
+static inline int sched_mutex_trylock(sched_mutex_t *m)
+{
+    if (*m) return 0;
+    *m = 1;
+    return 1;
+}
+
+static inline void sched_mutex_unlock(sched_mutex_t *m)
+{
+    *m = 0;
+}
+
+#if SCHED_ENABLE
+void sched_add(sched_task_t *t, uint8_t (*func)(sched_task_t *t), uint8_t flags);
+void sched_poll(void);
+void sched_run(void);
+void sched_yield(void);
+#else
+#define sched_yield()   ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SCHED_H */
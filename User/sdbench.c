@@ -0,0 +1,382 @@
+/*********************************************************************************
+ * File Name          : sdbench.c
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : On-device storage benchmark.
+ *******************************************************************************/
+#include "sdbench.h"
+#include "diskio.h"
+#include "prof.h"
+
+#if SDBENCH_ENABLE
+
+#define FILE_NAME   "bench.bin"
+#define CHURN_NAME  "churn.tmp"
+
+/* Test in progress */
+static struct
+{
+    uint32_t Start;         /* SysTick at the start of the test */
+    uint32_t T0;            /* SysTick at the start of the operation */
+    uint32_t Ops;
+    uint32_t Bytes;
+    uint32_t Max;
+    uint16_t Hist[SDBENCH_BUCKETS];
+} Test;
+
+static BYTE Buf[SDBENCH_REC_SIZE];
+static uint32_t Seed = 1;
+
+static uint32_t rnd(void)       /* xorshift32 */
+{
+    Seed ^= Seed << 13;
+    Seed ^= Seed >> 17;
+    Seed ^= Seed << 5;
+    return Seed;
+}
+
+/* Histogram bucket of a time: 0..3 units exact, then 4 buckets per octave */
+static uint8_t bucket(uint32_t t)
+{
+    uint8_t e = 0;
+
+    t >>= SDBENCH_HIST_SHIFT;
+    if (t < 4) return (uint8_t)t;
+    while (t >= 8) {
+        t >>= 1;
+        e++;
+    }
+    e = 4 * (e + 1) + (uint8_t)(t - 4);
+    return (e < SDBENCH_BUCKETS) ? e : SDBENCH_BUCKETS - 1;
+}
+
+/* Upper bound of a bucket in SysTick counts */
+static uint32_t bucket_top(uint8_t b)
+{
+    if (b < 4) return (uint32_t)(b + 1) << SDBENCH_HIST_SHIFT;
+    return (uint32_t)(5 + b % 4) << (b / 4 - 1 + SDBENCH_HIST_SHIFT);
+}
+
+static void test_begin(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < SDBENCH_BUCKETS; i++) Test.Hist[i] = 0;
+    Test.Ops = Test.Bytes = Test.Max = 0;
+    Test.Start = SysTick->CNT;
+}
+
+static void op_begin(void)
+{
+    Test.T0 = SysTick->CNT;
+}
+
+static void op_end(uint32_t bytes)
+{
+    uint32_t t = SysTick->CNT - Test.T0;
+    uint16_t *h = &Test.Hist[bucket(t)];
+
+    if (*h != 0xFFFF) (*h)++;
+    if (t > Test.Max) Test.Max = t;
+    Test.Ops++;
+    Test.Bytes += bytes;
+}
+
+/* Time below which pct percent of the operations completed, in counts */
+static uint32_t percentile(uint8_t pct)
+{
+    uint32_t n = 0, want = (Test.Ops * pct + 99) / 100;
+    uint8_t b;
+
+    for (b = 0; b < SDBENCH_BUCKETS; b++) {
+        n += Test.Hist[b];
+        if (n >= want) break;
+    }
+    if (b < SDBENCH_BUCKETS - 1 && bucket_top(b) < Test.Max) return bucket_top(b);
+    return Test.Max;
+}
+
+static FRESULT test_end(const char *name, FRESULT res)
+{
+    uint32_t per_us = SystemCoreClock / 8000000;
+    uint32_t ms = (SysTick->CNT - Test.Start) / (per_us * 1000);
+
+    if (ms == 0) ms = 1;
+    if (res != FR_OK) {
+        printf("BENCH %s error:%d ops:%d\r\n", name, res, Test.Ops);
+    } else {
+        printf("BENCH %s ops:%d bytes:%d ms:%d kBps:%d iops:%d p50:%dus p99:%dus max:%dus\r\n",
+               name, Test.Ops, Test.Bytes, ms, Test.Bytes / ms, Test.Ops * 1000 / ms,
+               percentile(50) / per_us, percentile(99) / per_us, Test.Max / per_us);
+    }
+    return res;
+}
+
+static FRESULT seq_write(void)
+{
+    FIL fil;
+    UINT bw;
+    uint32_t n;
+    FRESULT res;
+
+    test_begin();
+    res = f_open(&fil, FILE_NAME, FA_CREATE_ALWAYS | FA_WRITE);
+    if (res == FR_OK) {
+        for (n = 0; n < SDBENCH_REC_SIZE; n++) Buf[n] = (BYTE)n;
+        for (n = 0; res == FR_OK && n < (uint32_t)SDBENCH_FILE_KB * 1024 / SDBENCH_REC_SIZE; n++) {
+            op_begin();
+            res = f_write(&fil, Buf, SDBENCH_REC_SIZE, &bw);
+            if (res == FR_OK && bw != SDBENCH_REC_SIZE) res = FR_DENIED;    /* Volume full */
+            op_end(bw);
+        }
+        if (res == FR_OK) res = f_close(&fil); else f_close(&fil);
+    }
+    return test_end("seq_write", res);
+}
+
+static FRESULT seq_read(void)
+{
+    FIL fil;
+    UINT br;
+    FRESULT res;
+
+    test_begin();
+    res = f_open(&fil, FILE_NAME, FA_READ);
+    if (res == FR_OK) {
+        for (;;) {
+            op_begin();
+            res = f_read(&fil, Buf, SDBENCH_REC_SIZE, &br);
+            if (res != FR_OK || br == 0) break;
+            op_end(br);
+        }
+        f_close(&fil);
+    }
+    return test_end("seq_read", res);
+}
+
+static FRESULT rand_io(uint8_t write)
+{
+    FIL fil;
+    UINT bw;
+    uint32_t n, sectors;
+    FRESULT res;
+
+    test_begin();
+    res = f_open(&fil, FILE_NAME, write ? FA_WRITE : FA_READ);
+    if (res == FR_OK) {
+        sectors = (uint32_t)(f_size(&fil) / 512);
+        if (sectors == 0) res = FR_NO_FILE;
+        for (n = 0; res == FR_OK && n < SDBENCH_RAND_OPS; n++) {
+            bw = 0;
+            op_begin();
+            res = f_lseek(&fil, (FSIZE_t)(rnd() % sectors) * 512);
+            if (res == FR_OK) res = write ? f_write(&fil, Buf, 512, &bw) : f_read(&fil, Buf, 512, &bw);
+            if (write && res == FR_OK) res = f_sync(&fil);      /* Make each write reach the card */
+            op_end(bw);
+        }
+        if (res == FR_OK) res = f_close(&fil); else f_close(&fil);
+    }
+    return test_end(write ? "rand_write" : "rand_read", res);
+}
+
+static FRESULT rand_read(void)
+{
+    return rand_io(0);
+}
+
+static FRESULT rand_write(void)
+{
+    return rand_io(1);
+}
+
+static FRESULT append(void)
+{
+    FIL fil;
+    UINT bw;
+    uint32_t n;
+    FRESULT res;
+
+    test_begin();
+    res = f_open(&fil, "append.log", FA_CREATE_ALWAYS | FA_WRITE);
+    if (res == FR_OK) {
+        for (n = 0; res == FR_OK && n < SDBENCH_APPEND_OPS; n++) {
+            op_begin();
+            res = f_write(&fil, Buf, SDBENCH_APPEND_SIZE, &bw);
+            if (res == FR_OK && (n + 1) % SDBENCH_SYNC_EVERY == 0) res = f_sync(&fil);
+            op_end(bw);
+        }
+        if (res == FR_OK) res = f_close(&fil); else f_close(&fil);
+        f_unlink("append.log");
+    }
+    return test_end("append", res);
+}
+
+/* Same sequence as xchg_spi() in diskio.c, clocking 0xFF */
+static inline __attribute__((always_inline)) void spi_loop(uint32_t n)
+{
+    do {
+        Buf[0] = SPI_Xchg_Fast(SPI1, 0xFF);
+    } while (--n);
+}
+
+static __attribute__((noinline)) void spi_loop_flash(uint32_t n)
+{
+    spi_loop(n);
+}
+
+static RAMFUNC void spi_loop_ram(uint32_t n)
+{
+    spi_loop(n);
+}
+
+/* The card ignores the clock while CS is high, as between disk_xxx calls */
+static FRESULT spi(void)
+{
+    void (*const loops[2])(uint32_t) = { spi_loop_flash, spi_loop_ram };
+    uint8_t i;
+    uint32_t n;
+
+    for (i = 0; i < 2; i++) {
+        test_begin();
+        disk_claim();                   /* No PFAIL flush between the bytes */
+        for (n = 0; n < SDBENCH_SPI_OPS; n++) {
+            op_begin();
+            loops[i](SDBENCH_REC_SIZE);
+            op_end(SDBENCH_REC_SIZE);
+        }
+        disk_release();
+        test_end(i ? "spi_ram" : "spi_flash", FR_OK);
+    }
+    return FR_OK;
+}
+
+/* Cycles per call of a library function and of its ch32v00x_fast.h twin, loop included */
+#define API_CALLS   1024
+#define API_TIME(t, call)                                   \
+    do {                                                    \
+        uint32_t n = API_CALLS, t0 = SysTick->CNT;          \
+        do { call; } while (--n);                           \
+        t = (SysTick->CNT - t0) * 8 / API_CALLS;            \
+    } while (0)
+
+static void api_line(const char *name, uint32_t std, uint32_t fast)
+{
+    printf("BENCH api_%s calls:%d std:%d fast:%d cycles\r\n", name, API_CALLS, std, fast);
+}
+
+/* Read-only or idempotent accesses: CS stays high, the console is not written */
+static FRESULT api(void)
+{
+    uint32_t std, fast;
+
+    API_TIME(std, GPIO_WriteBit(GPIOC, GPIO_Pin_3, Bit_SET));
+    API_TIME(fast, GPIO_WriteBit_Fast(GPIOC, GPIO_Pin_3, Bit_SET));
+    api_line("gpio_write", std, fast);
+
+    API_TIME(std, Buf[0] = GPIO_ReadInputDataBit(GPIOC, GPIO_Pin_3));
+    API_TIME(fast, Buf[0] = GPIO_ReadInputDataBit_Fast(GPIOC, GPIO_Pin_3));
+    api_line("gpio_read", std, fast);
+
+    API_TIME(std,
+        while (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_TXE) == RESET);
+        SPI_I2S_SendData(SPI1, 0xFF);
+        while (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_RXNE) == RESET);
+        Buf[0] = (BYTE)SPI_I2S_ReceiveData(SPI1));
+    API_TIME(fast,
+        while (SPI_I2S_GetFlagStatus_Fast(SPI1, SPI_I2S_FLAG_TXE) == RESET);
+        SPI_I2S_SendData_Fast(SPI1, 0xFF);
+        while (SPI_I2S_GetFlagStatus_Fast(SPI1, SPI_I2S_FLAG_RXNE) == RESET);
+        Buf[0] = (BYTE)SPI_I2S_ReceiveData_Fast(SPI1));
+    api_line("spi_byte", std, fast);
+
+    API_TIME(std, Buf[0] = USART_GetFlagStatus(USART1, USART_FLAG_RXNE));
+    API_TIME(fast, Buf[0] = USART_GetFlagStatus_Fast(USART1, USART_FLAG_RXNE));
+    api_line("usart_flag", std, fast);
+
+    API_TIME(std, Buf[0] = (BYTE)DMA_GetCurrDataCounter(DMA1_Channel4));
+    API_TIME(fast, Buf[0] = (BYTE)DMA_GetCurrDataCounter_Fast(DMA1_Channel4));
+    api_line("dma_count", std, fast);
+
+    return FR_OK;
+}
+
+static FRESULT churn(void)
+{
+    FIL fil;
+    UINT bw;
+    uint32_t n;
+    FRESULT res = FR_OK;
+
+    test_begin();
+    for (n = 0; res == FR_OK && n < SDBENCH_CHURN_OPS; n++) {
+        op_begin();
+        res = f_open(&fil, CHURN_NAME, FA_CREATE_ALWAYS | FA_WRITE);
+        if (res == FR_OK) {
+            res = f_write(&fil, Buf, SDBENCH_APPEND_SIZE, &bw);
+            if (res == FR_OK) res = f_close(&fil); else f_close(&fil);
+        }
+        if (res == FR_OK) res = f_unlink(CHURN_NAME);
+        op_end(0);
+    }
+    return test_end("churn", res);
+}
+
+/*********************************************************************
+ * @fn      SDBENCH_Run
+ *
+ * @brief   Runs the selected tests on the mounted default volume, in the
+ *        order of their bits, and prints a line per test.
+ *
+ * @param   tests - SDBENCH_xxx bits.
+ *
+ * @return  FR_OK or the error of the first test that failed.
+ */
+FRESULT SDBENCH_Run(uint8_t tests)
+{
+    static FRESULT (*const Tests[])(void) = {
+        seq_write, seq_read, rand_read, rand_write, append, churn, spi, api
+    };
+    FRESULT res = FR_OK, r;
+    uint8_t i;
+
+    for (i = 0; i < sizeof(Tests) / sizeof(Tests[0]); i++) {
+        if (tests & (1 << i)) {
+            r = Tests[i]();
+            if (res == FR_OK) res = r;
+        }
+    }
+    printf("BENCH end\r\n");
+    return res;
+}
+
+/*********************************************************************
+ * @fn      SDBENCH_Poll
+ *
+ * @brief   Handles a console command received on USART1, if any:
+ *        SDBENCH_CMD_ALL runs every test, '1' to '8' a single one.
+ *        The profiler commands are passed on to it.
+ *
+ * @return  none
+ */
+void SDBENCH_Poll(void)
+{
+    uint8_t c;
+
+    if (USART1->STATR & USART_FLAG_RXNE) {
+        c = (uint8_t)USART1->DATAR;
+        if (c == SDBENCH_CMD_ALL) {
+            SDBENCH_Run(SDBENCH_ALL);
+        } else if (c >= SDBENCH_CMD_FIRST && c < SDBENCH_CMD_FIRST + 8) {
+            SDBENCH_Run(1 << (c - SDBENCH_CMD_FIRST));
+        }
+#if PROF_ENABLE
+        else if (c == PROF_CMD_DUMP) {
+            PROF_Dump();
+        } else if (c == PROF_CMD_RESET) {
+            PROF_Reset();
+        }
+#endif
+    }
+}
+
+#endif /* SDBENCH_ENABLE */
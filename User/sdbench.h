@@ -0,0 +1,114 @@
+/*********************************************************************************
+ * File Name          : sdbench.h
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : On-device storage benchmark.
+ *********************************************************************************
+ * Runs a set of tests on the mounted volume and prints one line per test:
+ *
+ *   BENCH seq_write ops:2048 bytes:1048576 ms:2210 kBps:474 iops:926 p50:1024us p99:1536us max:9813us
+ *
+ * Every operation is timed with SysTick and counted in a histogram of quarter
+ * octave buckets, so p50/p99 are upper bucket bounds (at most 25% high). kBps is
+ * bytes per millisecond and iops counts the timed operations, both over the
+ * whole test including f_open/f_close/f_sync.
+ *
+ *   seq_write   SDBENCH_FILE_KB to bench.bin in SDBENCH_REC_SIZE records
+ *   seq_read    bench.bin back in SDBENCH_REC_SIZE records
+ *   rand_read   SDBENCH_RAND_OPS 512-byte reads at random sectors of bench.bin
+ *   rand_write  SDBENCH_RAND_OPS 512-byte writes at random sectors of bench.bin
+ *   append      SDBENCH_APPEND_OPS records of SDBENCH_APPEND_SIZE bytes with
+ *               f_sync after every SDBENCH_SYNC_EVERY of them
+ *   churn       SDBENCH_CHURN_OPS times create, write a record, close, delete
+ *   spi_flash   SDBENCH_SPI_OPS runs of the SPI byte loop of the disk driver
+ *   spi_ram     over SDBENCH_REC_SIZE bytes with the card deselected, one copy
+ *               of the loop in flash and one in RAMFUNC (RAM, see debug.h)
+ *   api_xxx     CPU cycles per call of GPIO, SPI, USART and DMA library
+ *               functions (std) and of their ch32v00x_fast.h versions (fast),
+ *               loop overhead included
+ *
+ * The read and random tests use the file left by seq_write.
+ *******************************************************************************/
+#ifndef __SDBENCH_H
+#define __SDBENCH_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "debug.h"
+#include "ff.h"
+
+/* Storage Benchmark Definition */
+#ifndef SDBENCH_ENABLE
+#define SDBENCH_ENABLE      0
+#endif
+
+#ifndef SDBENCH_AUTORUN
+#define SDBENCH_AUTORUN     SDBENCH_ALL             /* Tests run at start-up in APP_SD_BENCH mode */
+#endif
+
+#ifndef SDBENCH_FILE_KB
+#define SDBENCH_FILE_KB     1024
+#endif
+
+#ifndef SDBENCH_REC_SIZE
+#define SDBENCH_REC_SIZE    512                     /* Sequential record size, also the buffer size */
+#endif
+
+#ifndef SDBENCH_RAND_OPS
+#define SDBENCH_RAND_OPS    256
+#endif
+
+#ifndef SDBENCH_APPEND_SIZE
+#define SDBENCH_APPEND_SIZE 32
+#endif
+
+#ifndef SDBENCH_APPEND_OPS
+#define SDBENCH_APPEND_OPS  1024
+#endif
+
+#ifndef SDBENCH_SYNC_EVERY
+#define SDBENCH_SYNC_EVERY  16
+#endif
+
+#ifndef SDBENCH_CHURN_OPS
+#define SDBENCH_CHURN_OPS   64
+#endif
+
+#ifndef SDBENCH_SPI_OPS
+#define SDBENCH_SPI_OPS     256
+#endif
+
+#if (SDBENCH_REC_SIZE < 512) || (SDBENCH_REC_SIZE < SDBENCH_APPEND_SIZE)
+#error SDBENCH_REC_SIZE must be at least 512 and SDBENCH_APPEND_SIZE
+#endif
+
+#define SDBENCH_HIST_SHIFT  3                       /* Histogram unit, 2^3 SysTick counts (1.3us at 48MHz) */
+#define SDBENCH_BUCKETS     68                      /* Last bucket starts at 2^22 SysTick counts (0.7s) */
+
+/* Tests */
+#define SDBENCH_SEQ_WRITE   0x01
+#define SDBENCH_SEQ_READ    0x02
+#define SDBENCH_RAND_READ   0x04
+#define SDBENCH_RAND_WRITE  0x08
+#define SDBENCH_APPEND      0x10
+#define SDBENCH_CHURN       0x20
+#define SDBENCH_SPI         0x40
+#define SDBENCH_API         0x80
+#define SDBENCH_ALL         0xFF
+
+/* Console commands handled by SDBENCH_Poll ('1'.. runs a single test) */
+#define SDBENCH_CMD_ALL     'b'
+#define SDBENCH_CMD_FIRST   '1'
+
+#if SDBENCH_ENABLE
+FRESULT SDBENCH_Run(uint8_t tests);
+void    SDBENCH_Poll(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SDBENCH_H */
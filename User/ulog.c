@@ -0,0 +1,261 @@
+/*********************************************************************************
+ * File Name          : ulog.c
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : USART1 receive logger to SD card.
+ *******************************************************************************/
+#include "ulog.h"
+
+#if ULOG_ENABLE
+
+void DMA1_Channel5_IRQHandler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
+void USART1_IRQHandler(void) __attribute__((interrupt("WCH-Interrupt-fast")));
+
+volatile ULOG_StatTypeDef ULOG_Stat;
+
+static uint8_t Ring[ULOG_RING_SIZE];
+static volatile uint32_t Head;          /* Bytes stored by DMA since ULOG_Start */
+static uint16_t LastPos;                /* Ring offset of Head */
+static uint32_t Tail;                   /* Bytes taken out of the ring */
+static uint32_t SeenFrames;             /* ULOG_Stat.Frames at the last idle flush */
+
+/*********************************************************************
+ * @fn      update_head
+ *
+ * @brief   Advance Head to the current DMA position. It is called at
+ *        least twice per lap of the ring, so the distance moved since
+ *        the last call is always less than the ring size.
+ *
+ * @return  none
+ */
+static void update_head(void)
+{
+    uint16_t pos = ULOG_RING_SIZE - DMA1_Channel5->CNTR;
+
+    if (pos == ULOG_RING_SIZE) pos = 0;
+    Head += (pos >= LastPos) ? pos - LastPos : ULOG_RING_SIZE + pos - LastPos;
+    LastPos = pos;
+}
+
+/*********************************************************************
+ * @fn      ring_head
+ *
+ * @brief   Get the up-to-date Head from the thread level.
+ *
+ * @return  Bytes stored by DMA since ULOG_Start
+ */
+static uint32_t ring_head(void)
+{
+    uint32_t head;
+
+    __disable_irq();
+    update_head();
+    head = Head;
+    __enable_irq();
+
+    return head;
+}
+
+/*********************************************************************
+ * @fn      drain
+ *
+ * @brief   Write the ring to the file in chunks that end on sector
+ *        boundaries of the file. A shorter chunk is written only when
+ *        the burst has ended or everything is requested.
+ *
+ * @param   fp - File opened for writing.
+ *          all - 1:write everything that has been received.
+ *
+ * @return  FR_OK, FR_DENIED on volume full, or the f_write/f_sync error.
+ */
+static FRESULT drain(FIL *fp, uint8_t all)
+{
+    FRESULT res = FR_OK;
+    uint32_t frames, head, avail, lost;
+    UINT n, bw;
+
+    while (1) {
+        frames = ULOG_Stat.Frames;      /* Take it before the head, an idle after this is seen next time */
+        head = ring_head();
+        avail = head - Tail;
+        if (avail > ULOG_RING_SIZE) {   /* Lapped by DMA, skip what has been overwritten */
+            lost = avail - ULOG_RING_SIZE;
+            ULOG_Stat.Overruns += lost;
+            Tail += lost;
+            avail = ULOG_RING_SIZE;
+        }
+
+        n = 512 - (UINT)(f_tell(fp) % 512);
+        if (n > ULOG_RING_SIZE - Tail % ULOG_RING_SIZE) n = ULOG_RING_SIZE - Tail % ULOG_RING_SIZE;
+        if (avail < n) {
+            if (!all && frames == SeenFrames) break;    /* Wait for a whole chunk */
+            if (avail == 0) {                           /* Burst is in the file, make it durable */
+                SeenFrames = frames;
+                res = f_sync(fp);
+                break;
+            }
+            n = avail;
+        }
+
+        res = f_write(fp, Ring + Tail % ULOG_RING_SIZE, n, &bw);
+        if (res == FR_OK && bw != n) res = FR_DENIED;
+        if (res != FR_OK) break;
+
+        lost = ring_head() - Tail;      /* Was the chunk overwritten while it was written? */
+        if (lost > ULOG_RING_SIZE) {
+            lost -= ULOG_RING_SIZE;
+            ULOG_Stat.Overruns += (lost > n) ? n : lost;
+        }
+        Tail += n;
+        ULOG_Stat.Bytes += n;
+
+        if (f_tell(fp) % (512UL * ULOG_SYNC_BLOCKS) == 0) {
+            res = f_sync(fp);
+            if (res != FR_OK) break;
+        }
+    }
+
+    return res;
+}
+
+/*********************************************************************
+ * @fn      ULOG_Init
+ *
+ * @brief   Initializes DMA1 channel 5 and the idle-line interrupt for
+ *        USART1. The pins and the frame format are set by the caller,
+ *        the receiver does not run until ULOG_Start is called.
+ *
+ * @return  none
+ */
+void ULOG_Init(void)
+{
+    DMA_InitTypeDef DMA_InitStructure = {0};
+    NVIC_InitTypeDef NVIC_InitStructure = {0};
+
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+    /* DMA1 channel 5: USART1 RX, circular over the ring, interrupt at each half */
+    DMA_DeInit(DMA1_Channel5);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&USART1->DATAR;
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)Ring;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_BufferSize = ULOG_RING_SIZE;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_VeryHigh;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init(DMA1_Channel5, &DMA_InitStructure);
+    DMA_ITConfig(DMA1_Channel5, DMA_IT_HT | DMA_IT_TC, ENABLE);
+
+    /* Both interrupts update Head, they must not preempt each other */
+    NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel5_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
+    NVIC_InitStructure.NVIC_IRQChannel = USART1_IRQn;
+    NVIC_Init(&NVIC_InitStructure);
+}
+
+/*********************************************************************
+ * @fn      ULOG_Start
+ *
+ * @brief   Starts receiving from the top of the ring.
+ *
+ * @return  none
+ */
+void ULOG_Start(void)
+{
+    Head = Tail = 0;
+    LastPos = 0;
+    SeenFrames = ULOG_Stat.Frames;
+
+    DMA_Cmd(DMA1_Channel5, DISABLE);
+    DMA_SetCurrDataCounter(DMA1_Channel5, ULOG_RING_SIZE);
+    DMA_Cmd(DMA1_Channel5, ENABLE);
+
+    (void)USART1->STATR;                /* Drop a stale idle flag */
+    (void)USART1->DATAR;
+    USART_DMACmd(USART1, USART_DMAReq_Rx, ENABLE);
+    USART_ITConfig(USART1, USART_IT_IDLE, ENABLE);
+}
+
+/*********************************************************************
+ * @fn      ULOG_Stop
+ *
+ * @brief   Stops receiving. What is in the ring is still written by
+ *        ULOG_Flush.
+ *
+ * @return  none
+ */
+void ULOG_Stop(void)
+{
+    USART_ITConfig(USART1, USART_IT_IDLE, DISABLE);
+    USART_DMACmd(USART1, USART_DMAReq_Rx, DISABLE);
+    ring_head();
+    DMA_Cmd(DMA1_Channel5, DISABLE);
+}
+
+/*********************************************************************
+ * @fn      ULOG_Poll
+ *
+ * @brief   Writes the received data to the file. Whole chunks are
+ *        written as they fill, the rest of a burst is written and
+ *        synced once the line has gone idle.
+ *
+ * @param   fp - File opened for writing.
+ *
+ * @return  FR_OK, FR_DENIED on volume full, or the f_write/f_sync error.
+ */
+FRESULT ULOG_Poll(FIL *fp)
+{
+    return drain(fp, 0);
+}
+
+/*********************************************************************
+ * @fn      ULOG_Flush
+ *
+ * @brief   Writes everything received so far to the file and syncs it.
+ *
+ * @param   fp - File opened for writing.
+ *
+ * @return  FR_OK, FR_DENIED on volume full, or the f_write/f_sync error.
+ */
+FRESULT ULOG_Flush(FIL *fp)
+{
+    return drain(fp, 1);
+}
+
+/*********************************************************************
+ * @fn      DMA1_Channel5_IRQHandler
+ *
+ * @brief   Keeps Head no more than half a ring behind the DMA.
+ *
+ * @return  none
+ */
+void DMA1_Channel5_IRQHandler(void)
+{
+    DMA1->INTFCR = DMA1_IT_GL5 | DMA1_IT_TC5 | DMA1_IT_HT5 | DMA1_IT_TE5;
+    update_head();
+}
+
+/*********************************************************************
+ * @fn      USART1_IRQHandler
+ *
+ * @brief   Closes a burst when the line goes idle.
+ *
+ * @return  none
+ */
+void USART1_IRQHandler(void)
+{
+    if (USART1->STATR & USART_FLAG_IDLE) {
+        (void)USART1->DATAR;            /* STATR then DATAR read clears IDLE */
+        update_head();
+        ULOG_Stat.Frames++;
+    }
+}
+
+#endif /* ULOG_ENABLE */
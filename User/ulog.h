@@ -0,0 +1,67 @@
+/*********************************************************************************
+ * File Name          : ulog.h
+ * Version            : V1.0.0
+ * Date               : 2026/10/16
+ * Description        : USART1 receive logger to SD card.
+ *********************************************************************************
+ * DMA1 channel 5 copies every received byte into a circular ring, so nothing is
+ * lost while the CPU sits in disk_write. The ring position is taken from the DMA
+ * counter at each half-transfer/transfer-complete interrupt and at the USART
+ * idle-line interrupt, the latter closes a burst without waiting for the ring to
+ * fill. ULOG_Poll writes the ring to the file in chunks that end on file sector
+ * boundaries, and writes out the rest of a burst once the line stays idle.
+ *******************************************************************************/
+#ifndef __ULOG_H
+#define __ULOG_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "debug.h"
+#include "ff.h"
+
+/* UART Logger Definition */
+#ifndef ULOG_ENABLE
+#define ULOG_ENABLE         0
+#endif
+
+#ifndef ULOG_BAUD
+#define ULOG_BAUD           460800                  /* Bit rate of the captured stream */
+#endif
+
+#ifndef ULOG_RING_SIZE
+#define ULOG_RING_SIZE      512                     /* Multiple of 512 (11ms of data at 460800bps) */
+#endif
+
+#ifndef ULOG_SYNC_BLOCKS
+#define ULOG_SYNC_BLOCKS    64                      /* f_sync interval in sectors (32KB) */
+#endif
+
+#if (ULOG_RING_SIZE % 512) || (ULOG_RING_SIZE > 0xFFFF)
+#error ULOG_RING_SIZE must be a multiple of 512 and fit the DMA counter
+#endif
+
+/* UART logger statistics */
+typedef struct
+{
+    uint32_t Bytes;         /* Bytes written to the file */
+    uint32_t Frames;        /* Bursts closed by an idle line */
+    uint32_t Overruns;      /* Bytes overwritten by DMA before they were written */
+} ULOG_StatTypeDef;
+
+#if ULOG_ENABLE
+extern volatile ULOG_StatTypeDef ULOG_Stat;
+
+void    ULOG_Init(void);
+void    ULOG_Start(void);
+void    ULOG_Stop(void);
+FRESULT ULOG_Poll(FIL *fp);
+FRESULT ULOG_Flush(FIL *fp);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ULOG_H */